@@ -0,0 +1,169 @@
+#include "cdugks_mapper.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "mappers/default_mapper.h"
+
+using namespace Legion;
+using namespace Legion::Mapping;
+
+// CDUGKS mapper
+//
+// Differences from the default mapper:
+// 1) Instances of regions that carry velocity dimensions (grid, gridbarp,
+//    gridbarpb) are laid out with the velocity dimensions innermost, followed
+//    by the Dim/Dim2 components and then space, one field at a time (SoA).
+//    The step kernels loop over velocities for each cell.
+// 2) Every point of an index launch is sent to the same CPU in every launch,
+//    so a color is pinned to one core for the whole run.
+// 3) Instances are created in the NUMA (socket) memory closest to the CPU
+//    that runs the task. Since all regions of one color are used by tasks on
+//    the same CPU, they end up in the same NUMA domain, and halos are copied
+//    next to the task that consumes them.
+// 4) Instances cover exactly the requested region (what -dm:exact does for
+//    the default mapper).
+class CDUGKSMapper : public DefaultMapper {
+public:
+  CDUGKSMapper(MapperRuntime *rt, Machine machine, Processor local, const char *name);
+
+  virtual void slice_task(const MapperContext ctx, const Task &task,
+                          const SliceTaskInput &input, SliceTaskOutput &output);
+
+  virtual Memory default_policy_select_target_memory(MapperContext ctx,
+                                                     Processor target_proc,
+                                                     const RegionRequirement &req,
+                                                     MemoryConstraint mc = MemoryConstraint());
+
+  virtual void default_policy_select_constraints(MapperContext ctx,
+                                                 LayoutConstraintSet &constraints,
+                                                 Memory target_memory,
+                                                 const RegionRequirement &req);
+
+  virtual LogicalRegion default_policy_select_instance_region(MapperContext ctx,
+                                                              Memory target_memory,
+                                                              const RegionRequirement &req,
+                                                              const LayoutConstraintSet &constraints,
+                                                              bool force_new_instances,
+                                                              bool meets_constraints);
+
+private:
+  std::vector<Processor> local_cpus;          // Local CPUs in a fixed order
+  std::map<Processor, Memory> closest_memory; // NUMA memory (or sysmem) for every local CPU
+};
+
+CDUGKSMapper::CDUGKSMapper(MapperRuntime *rt, Machine machine, Processor local, const char *name)
+  : DefaultMapper(rt, machine, local, name)
+{
+  Machine::ProcessorQuery cpu_query(machine);
+  cpu_query.local_address_space().only_kind(Processor::LOC_PROC);
+  for (Machine::ProcessorQuery::iterator it = cpu_query.begin(); it != cpu_query.end(); it++)
+    local_cpus.push_back(*it);
+  std::sort(local_cpus.begin(), local_cpus.end());
+
+  for (size_t i = 0; i < local_cpus.size(); i++) {
+    Processor cpu = local_cpus[i];
+
+    // Prefer the socket memory of the CPU, fall back to system memory
+    Machine::MemoryQuery socket_query(machine);
+    socket_query.has_affinity_to(cpu).only_kind(Memory::SOCKET_MEM);
+    if (socket_query.count() > 0) {
+      closest_memory[cpu] = socket_query.first();
+      continue;
+    }
+
+    Machine::MemoryQuery sys_query(machine);
+    sys_query.has_affinity_to(cpu).only_kind(Memory::SYSTEM_MEM);
+    if (sys_query.count() > 0)
+      closest_memory[cpu] = sys_query.first();
+  }
+}
+
+void CDUGKSMapper::slice_task(const MapperContext ctx, const Task &task,
+                              const SliceTaskInput &input, SliceTaskOutput &output)
+{
+  if (task.target_proc.kind() != Processor::LOC_PROC || local_cpus.empty()) {
+    DefaultMapper::slice_task(ctx, task, input, output);
+    return;
+  }
+
+  // Linearize each point within the full launch domain (not just this shard's
+  // part of it) so that a color maps to the same CPU in every launch.
+  const Domain &launch = task.index_domain;
+  const DomainPoint lo = launch.lo();
+  const DomainPoint hi = launch.hi();
+
+  for (Domain::DomainPointIterator it(input.domain); it; it++) {
+    const DomainPoint &point = it.p;
+
+    size_t linear = 0;
+    for (int d = launch.get_dim() - 1; d >= 0; d--)
+      linear = linear*(hi[d] - lo[d] + 1) + (point[d] - lo[d]);
+
+    Processor target = local_cpus[linear % local_cpus.size()];
+    output.slices.push_back(TaskSlice(Domain(point, point), target,
+                                      false /*recurse*/, false /*stealable*/));
+  }
+}
+
+Memory CDUGKSMapper::default_policy_select_target_memory(MapperContext ctx,
+                                                         Processor target_proc,
+                                                         const RegionRequirement &req,
+                                                         MemoryConstraint mc)
+{
+  std::map<Processor, Memory>::const_iterator finder = closest_memory.find(target_proc);
+  if (finder != closest_memory.end() && !mc.is_valid())
+    return finder->second;
+  return DefaultMapper::default_policy_select_target_memory(ctx, target_proc, req, mc);
+}
+
+void CDUGKSMapper::default_policy_select_constraints(MapperContext ctx,
+                                                     LayoutConstraintSet &constraints,
+                                                     Memory target_memory,
+                                                     const RegionRequirement &req)
+{
+  // Regions are int8d with dimensions {x, y, z, Dim, Dim2, vx, vy, vz}.
+  // Only regions with a velocity extent get the velocity-innermost ordering.
+  Domain domain = runtime->get_index_space_domain(ctx, req.region.get_index_space());
+  if (req.privilege != LEGION_REDUCE && domain.get_dim() == 8 &&
+      constraints.ordering_constraint.ordering.empty()) {
+    const DomainPoint lo = domain.lo();
+    const DomainPoint hi = domain.hi();
+    coord_t nv = (hi[5] - lo[5] + 1)*(hi[6] - lo[6] + 1)*(hi[7] - lo[7] + 1);
+    if (nv > 1) {
+      static const int order[8] = {5, 6, 7, 3, 4, 0, 1, 2};
+      std::vector<DimensionKind> ordering;
+      for (int i = 0; i < 8; i++)
+        ordering.push_back(static_cast<DimensionKind>(static_cast<int>(LEGION_DIM_X) + order[i]));
+      ordering.push_back(LEGION_DIM_F); // Fields outermost: SoA
+      constraints.add_constraint(OrderingConstraint(ordering, false /*contiguous*/));
+    }
+  }
+
+  DefaultMapper::default_policy_select_constraints(ctx, constraints, target_memory, req);
+}
+
+LogicalRegion CDUGKSMapper::default_policy_select_instance_region(MapperContext ctx,
+                                                                  Memory target_memory,
+                                                                  const RegionRequirement &req,
+                                                                  const LayoutConstraintSet &constraints,
+                                                                  bool force_new_instances,
+                                                                  bool meets_constraints)
+{
+  // Pieces and halos are already exactly what a task touches
+  return req.region;
+}
+
+static void create_mappers(Machine machine, Runtime *runtime, const std::set<Processor> &local_procs)
+{
+  for (std::set<Processor>::const_iterator it = local_procs.begin(); it != local_procs.end(); it++) {
+    CDUGKSMapper *mapper = new CDUGKSMapper(runtime->get_mapper_runtime(), machine, *it, "cdugks_mapper");
+    runtime->replace_default_mapper(mapper, *it);
+  }
+}
+
+void register_mappers()
+{
+  Runtime::add_registration_callback(create_mappers);
+}
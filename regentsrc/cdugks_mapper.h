@@ -0,0 +1,16 @@
+#ifndef __CDUGKS_MAPPER_H__
+#define __CDUGKS_MAPPER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Registers the CDUGKS mapper in place of the default mapper on every local processor.
+// Passed to regentlib.start in Main.rg.
+void register_mappers();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CDUGKS_MAPPER_H__
@@ -0,0 +1,79 @@
+import numpy as np
+import argparse
+import glob
+import os
+
+# Reassembles the per-piece output of Main.rg into the global ./Data/rho_%04d,
+# rhovx_%04d, rhovy_%04d, rhovz_%04d, rhoE_%04d (and phase_%04d, bphase_%04d)
+# binary files read by plots.py. Run from the directory containing Data/.
+
+parser = argparse.ArgumentParser()
+parser.add_argument('-k', action='store_true', help='keep piece files after merging')
+args = parser.parse_args()
+
+W_fields = ['rho', 'rhovx', 'rhovy', 'rhovz', 'rhoE']
+phase_fields = {'g' : 'phase', 'b' : 'bphase'}
+
+def read_manifest(path):
+	manifest = {'W' : [], 'phase' : []}
+	for line in open(path):
+		key, *vals = line.split()
+		if key in ('W', 'phase'):
+			manifest[key].append(vals[0])
+		elif key in ('N', 'NV'):
+			manifest[key] = [int(v) for v in vals]
+		else:
+			manifest[key] = vals[0]
+	return manifest
+
+def read_piece(path, fmt):
+	# Returns lo, hi and a dictionary of 8d arrays in C order {vz, vy, vx, Dim2, Dim, z, y, x}
+	if fmt == 'h5':
+		import h5py
+		with h5py.File(path, 'r') as f:
+			lo = np.array(f.attrs['lo'])
+			hi = np.array(f.attrs['hi'])
+			fields = {name : np.array(f[name]) for name in f.keys()}
+		return lo, hi, fields
+
+	with open(path, 'rb') as f:
+		lo = np.fromfile(f, dtype=np.int32, count=8)
+		hi = np.fromfile(f, dtype=np.int32, count=8)
+		nfields = int(np.fromfile(f, dtype=np.int32, count=1)[0])
+		shape = tuple((hi - lo + 1)[::-1])
+		fields = {}
+		for i in range(nfields):
+			name = f.read(16).split(b'\0')[0].decode()
+			fields[name] = np.fromfile(f, dtype=np.float64, count=int(np.prod(shape))).reshape(shape)
+	return lo, hi, fields
+
+def assemble(paths, fmt, shape):
+	out = {}
+	for path in paths:
+		lo, hi, fields = read_piece(path, fmt)
+		box = tuple(slice(l, h + 1) for l, h in zip(lo[::-1], hi[::-1]))
+		for name, values in fields.items():
+			if name not in out:
+				out[name] = np.zeros(shape)
+			out[name][box] = values
+	return out
+
+for manifest_path in sorted(glob.glob('Data/manifest_*')):
+	manifest = read_manifest(manifest_path)
+	n = int(manifest['iter'])
+	N = manifest['N']
+	NV = manifest['NV']
+
+	W = assemble(manifest['W'], manifest['format'], (1, 1, 1, 1, 1, N[2], N[1], N[0]))
+	for name in W_fields:
+		W[name].tofile('Data/%s_%04d' % (name, n))
+
+	if manifest['phase']:
+		phase = assemble(manifest['phase'], manifest['format'], (NV[2], NV[1], NV[0], 1, 1, N[2], N[1], N[0]))
+		for name, prefix in phase_fields.items():
+			phase[name].tofile('Data/%s_%04d' % (prefix, n))
+
+	if not args.k:
+		for path in manifest['W'] + manifest['phase']:
+			os.remove(path)
+	print('Merged dump %d' % n)
@@ -0,0 +1,427 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Blocking.hh"
+#include "Evolution.hh"
+
+
+void BlockingInit(Blocking* B, int depth, int width, int* N, int* NV, int limiter, double* rh){
+
+	int Nc = N[0]*N[1]*N[2];
+	int Nv = NV[0]*NV[1]*NV[2];
+
+	B->depth = depth;
+	B->width = width;
+	B->L = width + 2*BLOCK_HALO*depth;
+	B->limiter = limiter;
+	B->rh = rh[0];
+
+	int L = B->L;
+
+	B->g = new double[L*Nv];
+	B->b = new double[L*Nv];
+	B->gbar = new double[L*Nv];
+	B->bbar = new double[L*Nv];
+	B->Fg = new double[L*Nv];
+	B->Fb = new double[L*Nv];
+
+	B->gbarp = new double[L];
+	B->bbarp = new double[L];
+	B->gsigma = new double[L];
+	B->bsigma = new double[L];
+	B->gsigma2 = new double[L];
+	B->bsigma2 = new double[L];
+
+	B->rho = new double[L];
+	B->rhov = new double[L];
+	B->rhoE = new double[L];
+	B->rhoh = new double[L];
+	B->rhovh = new double[L];
+	B->rhoEh = new double[L];
+	B->T = new double[L];
+	B->tg = new double[L];
+	B->tb = new double[L];
+	B->Q = new double[L];
+	B->cell = new int[L];
+
+	B->g2 = new double[Nc*Nv];
+	B->b2 = new double[Nc*Nv];
+	B->rho2 = new double[Nc];
+	B->rhov2 = new double[Nc];
+	B->rhoE2 = new double[Nc];
+}
+
+void BlockingFree(Blocking* B){
+
+	delete[] B->g; delete[] B->b; delete[] B->gbar; delete[] B->bbar; delete[] B->Fg; delete[] B->Fb;
+	delete[] B->gbarp; delete[] B->bbarp; delete[] B->gsigma; delete[] B->bsigma; delete[] B->gsigma2; delete[] B->bsigma2;
+	delete[] B->rho; delete[] B->rhov; delete[] B->rhoE; delete[] B->rhoh; delete[] B->rhovh; delete[] B->rhoEh;
+	delete[] B->T; delete[] B->tg; delete[] B->tb; delete[] B->Q; delete[] B->cell;
+	delete[] B->g2; delete[] B->b2; delete[] B->rho2; delete[] B->rhov2; delete[] B->rhoE2;
+}
+
+//Neighbor of window column p in the columns [clo, chi) computed this timestep.
+//Physical Dirichlet/Neumann boundaries clamp the same way, periodic ones are unwrapped in the window.
+static inline int Clamp(int p, int clo, int chi){
+
+	if(p < clo){return clo;}
+	if(p > chi - 1){return chi - 1;}
+	return p;
+}
+
+//One timestep of Step 1a through Step 4and5 on window columns [clo, chi) of width Lw starting at global x = lo.
+//Arithmetic is kept identical to the routines in Evolution.cc.
+template <int LIM> static void StepWindow(Blocking* B, int Lw, int lo, int clo, int chi, double dt, Cell* mesh, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, Source* S, int* BCs, double R, double K, double Pr, int* N, int* NV){
+
+	int Nv = NV[0]*NV[1]*NV[2];
+	int effD = 1;
+
+	double* g = B->g;
+	double* b = B->b;
+	double* gbar = B->gbar;
+	double* bbar = B->bbar;
+	double* rho = B->rho;
+	double* rhov = B->rhov;
+	double* rhoE = B->rhoE;
+	int* cell = B->cell;
+
+	//Step 1a taus at cell center
+	for(int p = clo; p < chi; p++){
+		double u = 0;
+		u += rhov[p]/rho[p]*rhov[p]/rho[p]; u = sqrt(u);
+		B->T[p] = Temperature(rhoE[p]/rho[p], u);
+		B->tg[p] = visc(B->T[p])/rho[p]/R/B->T[p];
+		B->tb[p] = B->tg[p]/Pr;
+	}
+
+	//Step 3: net heating from W at the start of the step
+	if(S->on){SourceRate(S, rho + clo, B->T + clo, B->Q + clo, chi - clo);}
+
+	//Step 1: one velocity row at a time, phibar at cell center, slopes, then phibar at interface at t+1/2
+	for(int vx = 0; vx < NV[0]; vx++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vz = 0; vz < NV[2]; vz++){
+
+				int v = vx + NV[0]*vy + NV[0]*NV[1]*vz;
+				double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+				double* gv = g + v*Lw;
+				double* bv = b + v*Lw;
+
+				for(int p = clo; p < chi; p++){
+					double tg = B->tg[p];
+					double tb = B->tb[p];
+					double T = B->T[p];
+
+					double c2 = 0;
+					c2 += (Xi[0]-rhov[p]/rho[p])*(Xi[0]-rhov[p]/rho[p]);
+					double g_eq = geq(c2, rho[p], T);
+					double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+					double Sg = 0.;
+					double Sb = 0.;
+					if(S->on){
+						double U[3] = {rhov[p]/rho[p], 0, 0};
+						SourceVelocity(effD, S->a + cell[p], B->Q[p], Xi, U, rho[p], T, R, g_eq, &Sg, &Sb);
+					}
+
+					B->gbarp[p] = (2*tg - dt/2.)/(2*tg)*gv[p] + dt/(4*tg)*g_eq + dt/4*Sg;
+					B->bbarp[p] = (2*tb - dt/2.)/(2*tb)*bv[p] + dt/(4*tb)*b_eq + dt/4*Sb;
+				}
+
+				for(int p = clo; p < chi; p++){
+					int pL = Clamp(p - 1, clo, chi);
+					int pR = Clamp(p + 1, clo, chi);
+					double xL = mesh[cell[pL]].x, xC = mesh[cell[p]].x, xR = mesh[cell[pR]].x;
+
+					B->gsigma[p] = LimitedSlope<LIM>(B->gbarp[pL], B->gbarp[p], B->gbarp[pR], xL, xC, xR, B->rh);
+					B->bsigma[p] = LimitedSlope<LIM>(B->bbarp[pL], B->bbarp[p], B->bbarp[pR], xL, xC, xR, B->rh);
+				}
+
+				double* gbv = gbar + v*Lw;
+				double* bbv = bbar + v*Lw;
+
+				for(int p = clo; p < chi; p++){
+					int pL = Clamp(p - 1, clo, chi);
+					int pR = Clamp(p + 1, clo, chi);
+					double xL = mesh[cell[pL]].x, xC = mesh[cell[p]].x, xR = mesh[cell[pR]].x;
+					double sC = mesh[cell[p]].dx;
+
+					B->gsigma2[p] = B->gsigma[p] + (sC/2)*LimitedSlope<LIM>(B->gsigma[pL], B->gsigma[p], B->gsigma[pR], xL, xC, xR, B->rh);
+					B->bsigma2[p] = B->bsigma[p] + (sC/2)*LimitedSlope<LIM>(B->bsigma[pL], B->bsigma[p], B->bsigma[pR], xL, xC, xR, B->rh);
+				}
+
+				int up = (Co_X[vx] < 0); // Upwind cell is the right neighbor
+				for(int p = clo; p < chi; p++){
+					int pR = Clamp(p + 1, clo, chi);
+					double sC = mesh[cell[p]].dx;
+
+					int ip = up ? pR : p;
+					double swap = up ? -1. : 1.;
+
+					double gbound = B->gbarp[ip] + swap*sC/2*B->gsigma[ip];
+					double bbound = B->bbarp[ip] + swap*sC/2*B->bsigma[ip];
+
+					gbv[p] = gbound;
+					bbv[p] = bbound;
+					gbv[p] -= dt/2.0*Xi[0]*B->gsigma2[ip];
+					bbv[p] -= dt/2.0*Xi[0]*B->bsigma2[ip];
+				}
+			}
+		}
+	}
+
+	//Step 2a: W at interface, moments over the whole window (columns outside [clo, chi) are unused)
+	double* gm = MomentsWork(M, 2*Lw);
+	Moments(M, gbar, Lw, MOM_RHO, 2, gm);
+	Moments(M, bbar, Lw, MOM_RHO, 1, B->rhoEh);
+
+	for(int p = clo; p < chi; p++){
+		B->rhoh[p] = gm[MOM_RHO*Lw + p];
+		B->rhovh[p] = gm[MOM_XI*Lw + p] + dt/2*B->rhoh[p]*S->a[cell[p]];
+		B->rhoEh[p] += dt/2.*gm[MOM_XI*Lw + p]*S->a[cell[p]];
+		B->rhoEh[p] += dt/2.*B->Q[p];
+
+		double u = 0;
+		u += B->rhovh[p]/B->rhoh[p]*B->rhovh[p]/B->rhoh[p]; u = sqrt(u);
+		B->T[p] = Temperature(B->rhoEh[p]/B->rhoh[p], u);
+		B->tg[p] = visc(B->T[p])/B->rhoh[p]/R/B->T[p];
+		B->tb[p] = B->tg[p]/Pr;
+	}
+
+	//Step 2b and 2c: phi at interface, then microflux
+	for(int vx = 0; vx < NV[0]; vx++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vz = 0; vz < NV[2]; vz++){
+
+				int v = vx + NV[0]*vy + NV[0]*NV[1]*vz;
+				double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+				double* gbv = gbar + v*Lw;
+				double* bbv = bbar + v*Lw;
+
+				for(int p = clo; p < chi; p++){
+					double tg = B->tg[p];
+					double tb = B->tb[p];
+					double T = B->T[p];
+
+					double c2 = 0;
+					c2 += (Xi[0]-B->rhovh[p]/B->rhoh[p])*(Xi[0]-B->rhovh[p]/B->rhoh[p]);
+					double g_eq = geq(c2, B->rhoh[p], T);
+					double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+					double Sg = 0.;
+					double Sb = 0.;
+					if(S->on){
+						double U[3] = {B->rhovh[p]/B->rhoh[p], 0, 0};
+						SourceVelocity(effD, S->a + cell[p], B->Q[p], Xi, U, B->rhoh[p], T, R, g_eq, &Sg, &Sb);
+					}
+
+					gbv[p] = 2*tg/(2*tg + dt/2.)*gbv[p] + dt/(4*tg + dt)*g_eq + dt*tg/(4*tg + dt)*Sg;
+					bbv[p] = 2*tb/(2*tb + dt/2.)*bbv[p] + dt/(4*tb + dt)*b_eq + dt*tb/(4*tb + dt)*Sb;
+				}
+
+				double* Fgv = B->Fg + v*Lw;
+				double* Fbv = B->Fb + v*Lw;
+
+				for(int p = clo; p < chi; p++){
+					int i = lo + p;
+					int pL = Clamp(p - 1, clo, chi);
+					double A = mesh[cell[p]].dy*mesh[cell[p]].dz;
+
+					double right = 1.0;
+					double left = 1.0;
+					if(BCs[0] == 1){if(i == 0){left = 0.; right = 0.;} if(i == N[0]-1){left = 0.; right = 0;}}
+					if(BCs[0] == 2){if(i == 0){left = 0;} if(i == N[0]-1){right = 0;}}
+
+					Fgv[p] = 0;
+					Fbv[p] = 0;
+					Fgv[p] += Xi[0]*A*(right*gbv[p] - left*gbv[pL]);
+					Fbv[p] += Xi[0]*A*(right*bbv[p] - left*bbv[pL]);
+				}
+			}
+		}
+	}
+
+	//Step 5, first half: old eq's and taus
+	for(int p = clo; p < chi; p++){
+		double u = 0;
+		u += rhov[p]/rho[p]*rhov[p]/rho[p]; u = sqrt(u);
+		B->T[p] = Temperature(rhoE[p]/rho[p], u);
+		B->tg[p] = visc(B->T[p])/rho[p]/R/B->T[p];
+		B->tb[p] = B->tg[p]/Pr;
+	}
+
+	for(int v = 0; v < Nv; v++){
+		int vx = v%NV[0], vy = (v/NV[0])%NV[1], vz = v/(NV[0]*NV[1]);
+		double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+		double* gv = g + v*Lw;
+		double* bv = b + v*Lw;
+
+		for(int p = clo; p < chi; p++){
+			int i = lo + p;
+			if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) || BCs[1] == 1 || BCs[2] == 1){continue;} // Dirichlet: no change
+
+			double V = mesh[cell[p]].dx*mesh[cell[p]].dy*mesh[cell[p]].dz;
+			double To = B->T[p];
+			double tgo = B->tg[p];
+			double tbo = B->tb[p];
+
+			double c2 = 0;
+			c2 += (Xi[0]-rhov[p]/rho[p])*(Xi[0]-rhov[p]/rho[p]);
+			double g_eqo = geq(c2, rho[p],To);
+			double b_eqo = g_eqo*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*To)/2;
+
+			double Sg = 0.;
+			double Sb = 0.;
+			if(S->on){
+				double U[3] = {rhov[p]/rho[p], 0, 0};
+				SourceVelocity(effD, S->a + cell[p], B->Q[p], Xi, U, rho[p], To, R, g_eqo, &Sg, &Sb);
+			}
+
+			gv[p] = gv[p] + dt/2*(g_eqo-gv[p])/tgo - dt/V*B->Fg[v*Lw + p] + dt*Sg;
+			bv[p] = bv[p] + dt/2*(b_eqo-bv[p])/tbo - dt/V*B->Fb[v*Lw + p] + dt*Sb;
+		}
+	}
+
+	//Step 4: W from the moments of the flux
+	double* Fm = MomentsWork(M, 3*Lw);
+	Moments(M, B->Fg, Lw, MOM_RHO, 2, Fm);
+	Moments(M, B->Fb, Lw, MOM_RHO, 1, Fm + 2*Lw);
+
+	for(int p = clo; p < chi; p++){
+		double V = mesh[cell[p]].dx*mesh[cell[p]].dy*mesh[cell[p]].dz;
+
+		int i = lo + p;
+		double Srhov = 0;
+		double SrhoE = 0;
+		if(S->on && !((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) || BCs[1] == 1 || BCs[2] == 1)){
+			SrhoE = B->Q[p];
+			Srhov = rho[p]*S->a[cell[p]];
+			SrhoE += rhov[p]*S->a[cell[p]];
+		}
+
+		rho[p] += -(dt/V*Fm[MOM_RHO*Lw + p]);
+		rhov[p] += -dt/V*Fm[MOM_XI*Lw + p] + dt*Srhov;
+		rhoE[p] += -dt/V*Fm[2*Lw + p] + dt*SrhoE;
+
+		double u = 0;
+		u += rhov[p]/rho[p]*rhov[p]/rho[p]; u = sqrt(u);
+		B->T[p] = Temperature(rhoE[p]/rho[p], u);
+		B->tg[p] = visc(B->T[p])/rho[p]/R/B->T[p];
+		B->tb[p] = B->tg[p]/Pr;
+	}
+
+	//Step 5, second half: new eq's and taus
+	for(int v = 0; v < Nv; v++){
+		int vx = v%NV[0], vy = (v/NV[0])%NV[1], vz = v/(NV[0]*NV[1]);
+		double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+		double* gv = g + v*Lw;
+		double* bv = b + v*Lw;
+
+		for(int p = clo; p < chi; p++){
+			int i = lo + p;
+			if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) || BCs[1] == 1 || BCs[2] == 1){continue;} // Dirichlet: no change
+
+			double T = B->T[p];
+			double tg = B->tg[p];
+			double tb = B->tb[p];
+
+			double c2 = 0;
+			c2 += (Xi[0]-rhov[p]/rho[p])*(Xi[0]-rhov[p]/rho[p]);
+			double g_eq = geq(c2, rho[p], T);
+			double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+			gv[p] = (gv[p] + dt/2*g_eq/tg)/(1+dt/2/tg);
+			bv[p] = (bv[p] + dt/2*b_eq/tb)/(1+dt/2/tb);
+		}
+	}
+}
+
+
+int EvolveBlocked(Blocking* B, double** g, double** b, double** rho, double** rhov, double** rhoE, double* dts, int* dump, int budget, double Tf, double Tsim, double dtdump, double Tdump, Cell* mesh, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, Source* S, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	assert(effD == 1);
+
+	int Nx = N[0];
+	int Nv = NV[0]*NV[1]*NV[2];
+	int periodic = (BCs[0] == 0);
+
+	//Timesteps of this block, same dt sequence as Evolve
+	double calcdt = StableTimeStep(N, Vmax);
+	int steps = 0;
+	*dump = 0;
+	int depth = (budget > 0 && budget < B->depth) ? budget : B->depth;
+	while(steps < depth && Tsim < Tf){
+		double dt = TimeStep(calcdt, dtdump-Tdump, Tf-Tsim);
+		dts[steps++] = dt;
+		Tsim += dt;
+		Tdump += dt;
+		if(dt < calcdt){*dump = 1; break;}
+	}
+
+	int halo = BLOCK_HALO*steps;
+
+	for(int a = 0; a < Nx; a += B->width){
+
+		int e = a + B->width < Nx ? a + B->width : Nx;
+
+		//Window [lo, hi) in global x, unwrapped if periodic
+		int lo = a - halo;
+		int hi = e + halo;
+		if(!periodic){
+			if(lo < 0){lo = 0;}
+			if(hi > Nx){hi = Nx;}
+		}
+		int Lw = hi - lo;
+
+		//Gather
+		for(int p = 0; p < Lw; p++){
+			int i = ((lo + p)%Nx + Nx)%Nx;
+			B->cell[p] = i;
+			B->rho[p] = (*rho)[i];
+			B->rhov[p] = (*rhov)[i];
+			B->rhoE[p] = (*rhoE)[i];
+		}
+		for(int v = 0; v < Nv; v++){
+			for(int p = 0; p < Lw; p++){
+				B->g[v*Lw + p] = (*g)[B->cell[p] + Nx*v];
+				B->b[v*Lw + p] = (*b)[B->cell[p] + Nx*v];
+			}
+		}
+
+		//Evolve, dropping the columns whose halo has gone stale after every step
+		for(int t = 0; t < steps; t++){
+			int clo = (lo == 0 && !periodic) ? 0 : BLOCK_HALO*t;
+			int chi = (hi == Nx && !periodic) ? Lw : Lw - BLOCK_HALO*t;
+
+			if(B->limiter == LIM_MINMOD){StepWindow<LIM_MINMOD>(B, Lw, lo, clo, chi, dts[t], mesh, Co_X, Co_Y, Co_Z, M, S, BCs, R, K, Pr, N, NV);}
+			else if(B->limiter == LIM_MC){StepWindow<LIM_MC>(B, Lw, lo, clo, chi, dts[t], mesh, Co_X, Co_Y, Co_Z, M, S, BCs, R, K, Pr, N, NV);}
+			else if(B->limiter == LIM_SUPERBEE){StepWindow<LIM_SUPERBEE>(B, Lw, lo, clo, chi, dts[t], mesh, Co_X, Co_Y, Co_Z, M, S, BCs, R, K, Pr, N, NV);}
+			else{StepWindow<LIM_VANLEER>(B, Lw, lo, clo, chi, dts[t], mesh, Co_X, Co_Y, Co_Z, M, S, BCs, R, K, Pr, N, NV);}
+		}
+
+		//Scatter the interior
+		for(int i = a; i < e; i++){
+			int p = i - lo;
+			B->rho2[i] = B->rho[p];
+			B->rhov2[i] = B->rhov[p];
+			B->rhoE2[i] = B->rhoE[p];
+		}
+		for(int v = 0; v < Nv; v++){
+			for(int i = a; i < e; i++){
+				B->g2[i + Nx*v] = B->g[v*Lw + i - lo];
+				B->b2[i + Nx*v] = B->b[v*Lw + i - lo];
+			}
+		}
+	}
+
+	double* swap;
+	swap = *g;    *g = B->g2;       B->g2 = swap;
+	swap = *b;    *b = B->b2;       B->b2 = swap;
+	swap = *rho;  *rho = B->rho2;   B->rho2 = swap;
+	swap = *rhov; *rhov = B->rhov2; B->rhov2 = swap;
+	swap = *rhoE; *rhoE = B->rhoE2; B->rhoE2 = swap;
+
+	return steps;
+}
@@ -0,0 +1,72 @@
+#ifndef BLOCKING_HH
+#define BLOCKING_HH
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+
+// Temporal blocking for 1D problems (effD = 1).
+// The x axis is cut into tiles that are advanced several timesteps at once. Each tile is
+// loaded with a halo of 3 cells per timestep (the reach of one step: Step 1b/1c read two
+// cells to the right and one to the left for the slopes, Step 2c one more to the left),
+// evolved in tile-local buffers that stay in cache, and its interior is written to a second
+// copy of the state, which is swapped with the caller's arrays at the end of the block.
+// Cells the halo has gone stale for are dropped from the computed range after every step,
+// so the interior matches the unblocked loop exactly.
+
+#define BLOCK_HALO 3 // Cells of halo per timestep
+
+struct Blocking{
+
+	int depth;   // Timesteps per block
+	int width;   // Interior cells per tile
+	int L;       // Allocated window columns, width + 2*BLOCK_HALO*depth
+	int limiter; // Slope limiter and 1/dx (0 if not uniform), as in StepKernels
+	double rh;
+
+	// Window state and interface/flux arrays, velocity-major f[v*Lw + p]
+	double* g;
+	double* b;
+	double* gbar;
+	double* bbar;
+	double* Fg;
+	double* Fb;
+
+	// One velocity row of the Step 1 intermediates
+	double* gbarp;
+	double* bbarp;
+	double* gsigma;
+	double* bsigma;
+	double* gsigma2;
+	double* bsigma2;
+
+	// Per window column
+	double* rho;
+	double* rhov;
+	double* rhoE;
+	double* rhoh;
+	double* rhovh;
+	double* rhoEh;
+	double* T;
+	double* tg;
+	double* tb;
+	double* Q;    // Net heating rate
+	int* cell;    // Global cell of the column
+
+	// Second copy of the state the tiles are written to
+	double* g2;
+	double* b2;
+	double* rho2;
+	double* rhov2;
+	double* rhoE2;
+};
+
+void BlockingInit(Blocking* B, int depth, int width, int* N, int* NV, int limiter, double* rh);
+void BlockingFree(Blocking* B);
+
+// Advance up to B->depth timesteps, and no more than budget if it is positive (what is left of -n).
+// A timestep whose dt is cut short by a dump or by Tf ends the block.
+// The timesteps taken are returned, with their dt in dts[], and *dump is set if the last one ends at a dump.
+int EvolveBlocked(Blocking* B, double** g, double** b, double** rho, double** rhov, double** rhoE, double* dts, int* dump, int budget, double Tf, double Tsim, double dtdump, double Tdump, Cell* mesh, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, Source* S, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Config.hh"
+
+void print_usage_and_abort(){
+
+	printf("Usage: ./cdugks [OPTIONS]\n");
+	printf("OPTIONS\n");
+	printf("  -h            : Print the usage and exit.\n");
+	printf("  -p {value}    : Test problem. 1 is Sod Shock, 2 is KHI (default).\n");
+	printf("  -f {file}     : Initial conditions file (see ICFormat.hh), overrides -p.\n");
+	printf("  -t {value}    : Threads used to build the initial distributions and by -g, 0 for one per core (default).\n");
+	printf("  -i {bool}     : Boolean: ask for confirmation of parameters and initial conditions (default 1).\n");
+	printf("  -n {value}    : Stop after {value} timesteps, 0 to run to the final time (default).\n");
+	printf("  -m {value}    : Cells along the test problem's most resolved axes, 0 for its own (default).\n");
+	printf("  -b {value}    : Timesteps per temporal block, 0 for none (default). 1D problems only.\n");
+	printf("  -w {value}    : Cells per tile when blocking, rows per slab with -u (default 64).\n");
+	printf("  -x {bool}     : Boolean: Strang-split sweeps along x, y, z instead of the unsplit step (default 0).\n");
+	printf("  -g {value}    : Slabs of the last axis advanced as a task graph on -t threads, 0 for none (default).\n");
+	printf("  -r {bool}     : Boolean: reproducible velocity moments, independent of how velocities are split (default 0).\n");
+	printf("  -k {value}    : Slope limiter: 0 van Leer (default), 1 minmod, 2 MC, 3 superbee.\n");
+	printf("  -e {value}    : Skip rows whose neighbourhood changed by less than {value} in its last step, 0 for none (default).\n");
+	printf("  -y {value}    : Knudsen number below which rows take a Navier-Stokes update instead of the kinetic step, 0 for none (default).\n");
+	printf("  -u {dir}      : Keep g and b in files under {dir} and step them through memory a slab at a time (default none).\n");
+	printf("  -c {value}    : Timesteps between health checks of the state, 0 for none (default 10).\n");
+	printf("  -o {bool}     : Boolean: output the full density at every dtdump (default 1).\n");
+	printf("  -s {file}     : Output selection: boxes, slices and probes, each with its own cadence (see Output.hh).\n");
+	printf("  -j {value}    : Timesteps between publications of the conserved fields to shared memory, 0 for none (default).\n");
+	printf("  -v {value}    : Publish every {value}-th cell along each axis with -j (default 1).\n");
+	printf("  -a {value}    : Constant gravitational acceleration along the last active dimension (default 0).\n");
+	printf("  -q {value}    : Heating rate per unit mass (default 0).\n");
+	printf("  -l {file}     : Radiative cooling curve, columns T and Lambda(T) (default none).\n");
+	exit(0);
+}
+
+void ConfigFromCommand(Config* config, int argc, char** argv){
+
+	config->testproblem = 2;
+	config->icfile = NULL;
+	config->threads = 0;
+	config->interactive = 1;
+	config->steps = 0;
+	config->cells = 0;
+	config->block = 0;
+	config->tile = 64;
+	config->split = 0;
+	config->slabs = 0;
+	config->repro = 0;
+	config->limiter = 0;
+	config->dormant = 0;
+	config->hybrid = 0;
+	config->ooc = NULL;
+	config->health = 10;
+	config->out = 1;
+	config->select = NULL;
+	config->live = 0;
+	config->livestride = 1;
+	config->gravity = 0;
+	config->heating = 0;
+	config->cooling = NULL;
+
+	int i = 1;
+	while(i < argc){
+		if(strcmp(argv[i], "-h") == 0){
+			print_usage_and_abort();
+		}else if(strcmp(argv[i], "-p") == 0){
+			i = i + 1;
+			config->testproblem = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-f") == 0){
+			i = i + 1;
+			config->icfile = argv[i];
+		}else if(strcmp(argv[i], "-t") == 0){
+			i = i + 1;
+			config->threads = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-i") == 0){
+			i = i + 1;
+			config->interactive = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-n") == 0){
+			i = i + 1;
+			config->steps = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-m") == 0){
+			i = i + 1;
+			config->cells = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-b") == 0){
+			i = i + 1;
+			config->block = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-w") == 0){
+			i = i + 1;
+			config->tile = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-x") == 0){
+			i = i + 1;
+			config->split = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-g") == 0){
+			i = i + 1;
+			config->slabs = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-r") == 0){
+			i = i + 1;
+			config->repro = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-k") == 0){
+			i = i + 1;
+			config->limiter = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-e") == 0){
+			i = i + 1;
+			config->dormant = atof(argv[i]);
+		}else if(strcmp(argv[i], "-y") == 0){
+			i = i + 1;
+			config->hybrid = atof(argv[i]);
+		}else if(strcmp(argv[i], "-u") == 0){
+			i = i + 1;
+			config->ooc = argv[i];
+		}else if(strcmp(argv[i], "-c") == 0){
+			i = i + 1;
+			config->health = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-o") == 0){
+			i = i + 1;
+			config->out = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-s") == 0){
+			i = i + 1;
+			config->select = argv[i];
+		}else if(strcmp(argv[i], "-j") == 0){
+			i = i + 1;
+			config->live = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-v") == 0){
+			i = i + 1;
+			config->livestride = atoi(argv[i]);
+		}else if(strcmp(argv[i], "-a") == 0){
+			i = i + 1;
+			config->gravity = atof(argv[i]);
+		}else if(strcmp(argv[i], "-q") == 0){
+			i = i + 1;
+			config->heating = atof(argv[i]);
+		}else if(strcmp(argv[i], "-l") == 0){
+			i = i + 1;
+			config->cooling = argv[i];
+		}
+		i = i + 1;
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef CONFIG_HH
+#define CONFIG_HH
+
+// Command line options, same flags as the Regent version where they overlap.
+struct Config{
+
+	int testproblem;  // 0 is None, 1 is Sod Shock, 2 is KHI, 3 is RTI.
+	char* icfile;     // External initial conditions (ICFormat.hh), in place of the test problem. NULL for none
+	int threads;      // Threads for initialization and the tiled step, 0 for one per core
+	int interactive;  // Wait for Enter/Return after printing parameters and initial conditions
+	int steps;        // Stop after this many timesteps, 0 to run to Tf
+	int cells;        // Cells along the test problem's most resolved axes, 0 for its own resolution
+	int block;        // Timesteps per temporal block, 0 for the unblocked loop (1D only)
+	int tile;         // Interior cells per tile when blocking, rows per slab out of core
+	int split;        // Directionally split sweeps (Sweep.hh) instead of the unsplit step
+	int slabs;        // Slabs of the tiled task graph step (Tiles.hh), 0 for the step by step loop
+	int repro;        // Sum velocity moments in the fixed pairwise order (MOM_VB leaves)
+	int limiter;      // Slope limiter, LIM_* in Limiters.hh
+	double dormant;   // Tolerance below which rows are left dormant (Dormant.hh), 0 for none
+	double hybrid;    // Knudsen number threshold of the hybrid continuum/kinetic step (Hybrid.hh), 0 for none
+	char* ooc;        // Directory of the out-of-core g and b files (OutOfCore.hh), NULL to keep them in memory
+	int health;       // Timesteps between health checks, 0 for none
+	int out;          // Write the full density at every dtdump
+	char* select;     // Output selection file (Output.hh), NULL for none
+	int live;         // Timesteps between publications of the live state to shared memory (Live.hh), 0 for none
+	int livestride;   // Every livestride-th cell along each active axis is published
+
+	// Source terms
+	double gravity;   // Constant acceleration along the last active dimension
+	double heating;   // Heating rate per unit mass
+	char* cooling;    // Cooling curve file, T and Lambda(T) columns, NULL for none
+};
+
+void print_usage_and_abort();
+void ConfigFromCommand(Config* config, int argc, char** argv);
+
+#endif
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Dormant.hh"
+
+
+void DormantInit(Dormant* Z, double tol, int* N, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+
+	Z->tol = tol;
+	Z->nrow = N[effD-1];
+	Z->quiet = new char[Z->nrow];
+	Z->noisy = new char[Z->nrow];
+	Z->awake = new char[Z->nrow];
+	Z->computed = new char[Z->nrow];
+	Z->run0 = new int[Z->nrow];
+	Z->run1 = new int[Z->nrow];
+	for(int r = 0; r < Z->nrow; r++){Z->quiet[r] = 0;} // Every row takes the first step
+	Z->nawake = Z->nrow;
+	Z->W0 = new double[(2+effD)*Nc];
+}
+
+void DormantFree(Dormant* Z){
+
+	delete[] Z->quiet;
+	delete[] Z->noisy;
+	delete[] Z->awake;
+	delete[] Z->computed;
+	delete[] Z->run0;
+	delete[] Z->run1;
+	delete[] Z->W0;
+}
+
+
+// Quiet flags of the awake rows after their step: the change of W first, then, for the rows it leaves quiet,
+// the distance of g and b from the equilibrium.
+static void DormantActivity(Dormant* Z, double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+	int plane = Nc/Z->nrow;
+
+	for(int r = 0; r < Z->nrow; r++){
+		if(!Z->awake[r]){continue;}
+
+		int quiet = 1;
+		for(int sidx = r*plane; sidx < (r+1)*plane && quiet; sidx++){
+			double* w0 = Z->W0 + (2+effD)*sidx;
+			double u = 0;
+			for(int d = 0; d < effD; d++){u += rhov[effD*sidx + d]/rho[sidx]*rhov[effD*sidx + d]/rho[sidx];} u = sqrt(u);
+			double T = Temperature(rhoE[sidx]/rho[sidx], u);
+			double dW = fabs(rho[sidx] - w0[0])/rho[sidx];
+			for(int d = 0; d < effD; d++){dW = fmax(dW, fabs(rhov[effD*sidx + d] - w0[1+d])/(rho[sidx]*sqrt(R*T)));}
+			dW = fmax(dW, fabs(rhoE[sidx] - w0[1+effD])/rhoE[sidx]);
+			quiet = (dW <= Z->tol);
+		}
+
+		for(int sidx = r*plane; sidx < (r+1)*plane && quiet; sidx++){
+			double u = 0;
+			for(int d = 0; d < effD; d++){u += rhov[effD*sidx + d]/rho[sidx]*rhov[effD*sidx + d]/rho[sidx];} u = sqrt(u);
+			double T = Temperature(rhoE[sidx]/rho[sidx], u);
+
+			double dg = 0, gmax = 0, db = 0, bmax = 0;
+			for(int vx = 0; vx < NV[0]; vx++){
+				for(int vy = 0; vy < NV[1]; vy++){
+					for(int vz = 0; vz < NV[2]; vz++){
+						int idx = sidx + Nc*vx + Nc*NV[0]*vy + Nc*NV[0]*NV[1]*vz;
+						double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+						double c2 = 0;
+						for(int d = 0; d < effD; d++){c2 += (Xi[d] - rhov[effD*sidx + d]/rho[sidx])*(Xi[d] - rhov[effD*sidx + d]/rho[sidx]);}
+						double g_eq = geq(c2, rho[sidx], T);
+						double b_eq = g_eq*(Xi[0]*Xi[0] + Xi[1]*Xi[1] + Xi[2]*Xi[2] + (3-effD+K)*R*T)/2;
+						dg = fmax(dg, fabs(g[idx] - g_eq));
+						db = fmax(db, fabs(b[idx] - b_eq));
+						gmax = fmax(gmax, g_eq);
+						bmax = fmax(bmax, b_eq);
+					}
+				}
+			}
+			quiet = (dg <= Z->tol*gmax && db <= Z->tol*bmax);
+		}
+
+		Z->quiet[r] = quiet;
+	}
+}
+
+
+int EvolveDormant(Dormant* Z, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
+
+	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
+
+	int dump = (*dt < calcdt);
+
+	int Nc = N[0]*N[1]*N[2];
+	int plane = Nc/Z->nrow;
+	int periodic = (BCs[effD-1] == 0);
+	double* work = MomentsWork(M, (1+effD)*Nc*effD + (2+effD)*Nc); // Step 2a moments, then Step 4's
+	double* Fm = work + (1+effD)*Nc*effD;
+
+	//Awake rows: any row that is not quiet wakes its neighbourhood
+	for(int r = 0; r < Z->nrow; r++){Z->noisy[r] = !Z->quiet[r];}
+	RowsWiden(Z->noisy, Z->awake, STEP_REACH, Z->nrow, periodic);
+	RowsWiden(Z->awake, Z->computed, STEP_REACH, Z->nrow, periodic);
+	Z->nawake = 0;
+	for(int r = 0; r < Z->nrow; r++){
+		Z->nawake += Z->awake[r];
+		if(!Z->awake[r]){continue;}
+		for(int sidx = r*plane; sidx < (r+1)*plane; sidx++){
+			double* w0 = Z->W0 + (2+effD)*sidx;
+			w0[0] = rho[sidx];
+			for(int d = 0; d < effD; d++){w0[1+d] = rhov[effD*sidx + d];}
+			w0[1+effD] = rhoE[sidx];
+		}
+	}
+
+	//Steps 3 to 2c on the runs of computed rows, then Steps 4 and 5 on the awake ones, each as in Evolve
+	int nrun = RowsRuns(Z->computed, Z->nrow, Z->run0, Z->run1);
+	for(int r = 0; r < nrun; r++){
+		int s0 = Z->run0[r];
+		int s1 = Z->run1[r];
+		Step3(S, rho, rhov, rhoE, N, effD, s0, s1);
+		SK->Step1a(g, b, gbar, bbar, gbarp, bbarp, S, rho, rhov, rhoE, *dt, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, 1, Z->run0[r], Z->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 1, 2, Z->run0[r], Z->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1c(gbar, bbar, gbarpbound, bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma2, bsigma2, *dt, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, Z->run0[r], Z->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		int s0 = Z->run0[r];
+		int s1 = Z->run1[r];
+		Step2a(gbar, bbar, M, S, *dt, rhoh, rhovh, rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, s0, s1, work, M->tree);
+		SK->Step2b(gbar, bbar, S, *dt, rhoh, rhovh, rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step2c(gbar, bbar, Co_X, Co_Y, Co_Z, mesh, gbarp, bbarp, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, Z->run0[r], Z->run1[r]);
+	}
+
+	nrun = RowsRuns(Z->awake, Z->nrow, Z->run0, Z->run1);
+	for(int r = 0; r < nrun; r++){
+		SK->Step4and5(rho, rhov, rhoE, *dt, mesh, gbarp, bbarp, Co_X, Co_Y, Co_Z, M, S, g, b, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, Z->run0[r], Z->run1[r], Fm, M->tree);
+	}
+
+	DormantActivity(Z, g, b, rho, rhov, rhoE, Co_X, Co_Y, Co_Z, R, K, N, NV, effD);
+
+	return dump;
+}
@@ -0,0 +1,40 @@
+#ifndef DORMANT_HH
+#define DORMANT_HH
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Evolution.hh"
+
+// Dormant rows (-e tol). Activity is tracked per row (slab one cell thick along the last active axis; a cell in 1D),
+// the unit the step kernels take. A row is quiet after a step when its W changed by at most tol (relative to
+// rho, rho*sqrt(RT) and rhoE) and its g and b are within tol of the local equilibrium (relative to their largest
+// equilibrium value). A row whose STEP_REACH neighbours on each side are all quiet, and which is quiet itself,
+// is dormant for the next step: its inputs are the same as for the step that left it unchanged, so all kernels
+// skip it. Any row that is not quiet wakes the rows within STEP_REACH, e.g. as a shock arrives.
+// The awake rows take the full step and Steps 3 to 2c also run on the STEP_REACH rows around them, which their
+// stencils read (the recycled scratch of dormant rows is stale). Dormant rows keep their quiet flag until they
+// are next awake. The step of every awake row is the step Evolve takes, so the results are bitwise the same while
+// all rows are awake, and a dormant row misses changes of the order of tol per step.
+
+struct Dormant{
+
+	double tol;
+	int nrow;        // Rows, N[effD-1]
+	char* quiet;     // Rows left unchanged by their last step
+	char* noisy;     // Scratch, !quiet
+	char* awake;     // Rows taking the step
+	char* computed;  // Rows running Steps 3 to 2c
+	int* run0;       // Runs of awake or computed rows, run0[r] <= s < run1[r]
+	int* run1;
+	int nawake;      // Awake rows of the last step
+	double* W0;      // W of the awake rows before the step, (2+effD) per cell
+};
+
+void DormantInit(Dormant* Z, double tol, int* N, int effD);
+void DormantFree(Dormant* Z);
+
+// Same contract as Evolve.
+int EvolveDormant(Dormant* Z, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
@@ -18,32 +18,43 @@ double TimeStep(double calcdt, double dumptime, double tend){
 	return timestep;
 }
 
+//CFL limited timestep
+double StableTimeStep(int* N, double* Vmax){
 
-int Evolve(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, double* Sg, double* Sb, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){	
-
-	//Find timestep
 	double CFL = 0.9; //safety factor
 	double dxmin = 1.0/fmax(fmax(N[0],N[1]),N[2]); //smallest cell width 
-	double umax = 2.0; // estimated maximum flow velocity , TODO calculate at each iteration for stronger problems
-	double calcdt = CFL*dxmin/(1.0+sqrt(Vmax[0]*Vmax[0] + Vmax[1]*Vmax[1] + Vmax[2]*Vmax[2]));
+	//double umax = 2.0; // estimated maximum flow velocity , TODO calculate at each iteration for stronger problems
+	return CFL*dxmin/(1.0+sqrt(Vmax[0]*Vmax[0] + Vmax[1]*Vmax[1] + Vmax[2]*Vmax[2]));
+}
+
+
+int Evolve(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){	
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
 
 	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
 	
 	int dump = (*dt < calcdt);
 
 
-	//Evolution Cycle
-	Step1a(g, b, gbar, bbar, gbarp, bbarp, Sg, Sb, rho, rhov, rhoE, *dt, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
-	Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
-	Step1c(gbar, bbar, gbarpbound, bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma2, bsigma2, *dt, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
-	
-	Step2a(gbar, bbar, Co_X, Co_Y, Co_Z, Co_WX, Co_WY, Co_WZ, *dt, rhoh, rhovh, rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
-	Step2b(gbar, bbar, *dt, rhoh, rhovh, rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD); //gbar, bbar are actually g/b at interface, recycling memory
-	Step2c(gbar, bbar, Co_X, Co_Y, Co_Z, mesh, gbarp, bbarp, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD); //gbar, bbar are actually g/b at interface, gbarp/bbarp are actually Fg/Fb -- Recycling memory
+	//Evolution Cycle, the whole domain as one slab
+	int s1 = N[effD-1];
+	int Nc = N[0]*N[1]*N[2];
+	double* work = MomentsWork(M, (1+effD)*Nc*effD + (2+effD)*Nc); // Step 2a moments, then Step 4's
+	double* Fm = work + (1+effD)*Nc*effD;
+
+	Step3(S, rho, rhov, rhoE, N, effD, 0, s1); //Sources from W at the start of the step, used from Step 1a on
+
+	SK->Step1a(g, b, gbar, bbar, gbarp, bbarp, S, rho, rhov, rhoE, *dt, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, s1);
+	SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, 2, 0, s1);
+	SK->Step1c(gbar, bbar, gbarpbound, bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma2, bsigma2, *dt, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, s1);
 	
-	Step3();
+	Step2a(gbar, bbar, M, S, *dt, rhoh, rhovh, rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, 0, s1, work, M->tree);
+	SK->Step2b(gbar, bbar, S, *dt, rhoh, rhovh, rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, s1); //gbar, bbar are actually g/b at interface, recycling memory
+	SK->Step2c(gbar, bbar, Co_X, Co_Y, Co_Z, mesh, gbarp, bbarp, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, s1); //gbar, bbar are actually g/b at interface, gbarp/bbarp are actually Fg/Fb -- Recycling memory
 	
-	Step4and5(rho, rhov, rhoE, *dt, mesh, gbarp, bbarp, Co_X, Co_Y, Co_Z, Co_WX, Co_WY, Co_WZ, g, b, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
+	SK->Step4and5(rho, rhov, rhoE, *dt, mesh, gbarp, bbarp, Co_X, Co_Y, Co_Z, M, S, g, b, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, s1, Fm, M->tree);
 	
 
 	return dump;
@@ -52,21 +63,26 @@ int Evolve(double* g, double* b, double* gbar, double* bbar, double* gbarp, doub
 
 //Step 1: Phibar at interface
 //Step 1a: Phibar at Cell Center.
-void Step1a(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, double* Sg, double* Sb, double* rho, double* rhov, double* rhoE, double dt, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+template <int D> static void Step1aK(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double dt, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int s0, int s1){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+
 
 	if(debug == 1){printf("Entering Step 1a\n");}
 
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
 
 	double tg;
 	double tb;
 	
 
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
+	for(int i = lo[0]; i < hi[0]; i++){
+		for(int j = lo[1]; j < hi[1]; j++){
+			for(int k = lo[2]; k < hi[2]; k++){
 				int sidx = i + Nx*j + Nx*Ny*k; //spatial index
 
 				
@@ -81,20 +97,12 @@ void Step1a(double* g, double* b, double* gbar, double* bbar, double* gbarp, dou
 							double u = 0;
 							for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} u = sqrt(u);
 
-							assert(u >= 0);
-
 							double T = Temperature(rhoE[sidx]/rho[sidx], u);
 
-							assert(T >= 0);
-
 
 							tg = visc(T)/rho[sidx]/R/T; // tau = mu/P, P = rho*R*T.
 							tb = tg/Pr;
 
-							//For Now...
-							Sg[sidx] = 0.;
-							Sb[sidx] = 0.;
-
 							double c2 = 0;
 							double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
 
@@ -103,13 +111,16 @@ void Step1a(double* g, double* b, double* gbar, double* bbar, double* gbarp, dou
 							double g_eq = geq(c2, rho[sidx], T);
 							double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
 
-							
-
-							gbarp[idx] = (2*tg - dt/2.)/(2*tg)*g[idx] + dt/(4*tg)*g_eq + dt/4*Sg[sidx];
-							bbarp[idx] = (2*tb - dt/2.)/(2*tb)*b[idx] + dt/(4*tb)*b_eq + dt/4*Sb[sidx];
+							double Sg = 0.;
+							double Sb = 0.;
+							if(S->on){
+								double U[3];
+								for(int dim = 0; dim < effD; dim++){U[dim] = rhov[effD*sidx + dim]/rho[sidx];}
+								SourceVelocity(effD, S->a + effD*sidx, S->Q[sidx], Xi, U, rho[sidx], T, R, g_eq, &Sg, &Sb);
+							}
 
-							assert(gbarp[idx] == gbarp[idx]); // NaN Checker
-							assert(bbarp[idx] == bbarp[idx]); // NaN Checker
+							gbarp[idx] = (2*tg - dt/2.)/(2*tg)*g[idx] + dt/(4*tg)*g_eq + dt/4*Sg;
+							bbarp[idx] = (2*tb - dt/2.)/(2*tb)*b[idx] + dt/(4*tb)*b_eq + dt/4*Sb;
 						}
 					}
 				}
@@ -118,167 +129,220 @@ void Step1a(double* g, double* b, double* gbar, double* bbar, double* gbarp, dou
 	}
 }
 
+//Velocity blocks of one sign per axis, so the upwind neighbor of Steps 1b/1c is fixed at block entry.
+//Cotes points are ascending: on each axis [0, split) is negative and [split, NV) is not.
+//Axes beyond effD are one block that is never upwinded.
+struct UpwindBlocks{
+	int n;
+	int lo[8][3];
+	int hi[8][3];
+	int up[8][3]; // 1 where the block's upwind cell is the right neighbor
+};
+
+static void SplitUpwind(UpwindBlocks* U, double* Co_X, double* Co_Y, double* Co_Z, const int* NV, int effD){
+	double* Co[3] = {Co_X, Co_Y, Co_Z};
+	int split[3];
+	for(int a = 0; a < 3; a++){
+		split[a] = 0;
+		if(a < effD){while(split[a] < NV[a] && Co[a][split[a]] < 0){split[a]++;}}
+	}
+
+	U->n = 0;
+	for(int blk = 0; blk < (1 << effD); blk++){
+		int empty = 0;
+		for(int a = 0; a < 3; a++){
+			int neg = (a < effD) && !((blk >> a) & 1);
+			U->lo[U->n][a] = neg ? 0 : split[a];
+			U->hi[U->n][a] = neg ? split[a] : NV[a];
+			U->up[U->n][a] = neg;
+			empty |= (U->lo[U->n][a] == U->hi[U->n][a]);
+		}
+		if(!empty){U->n++;}
+	}
+}
+
 //Step 1b: compute gradient of phibar to compute phibar at interface. compute phibar at interface.
-void Step1b(double* gbarp, double* bbarp, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* Co_X, double* Co_Y, double* Co_Z, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+template <int D, int BCX, int BCY, int BCZ, int LIM> static void Step1bK(double* gbarp, double* bbarp, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* rh, double* gbarpbound, double* bbarpbound, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int pass0, int pass1, int s0, int s1){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+	constexpr int BCs[3] = {BCX, BCY, BCZ};
+
 	
 	if(debug == 1){printf("Entering Step 1b\n");}
 
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
+	UpwindBlocks U;
+	SplitUpwind(&U, Co_X, Co_Y, Co_Z, NV, effD);
+
+	//Velocities run outside the cells, so gbarp/gsigma are read along i at unit stride.
+	//Pass 0 computes phisigma at every cell, pass 1 the interface slopes and values,
+	//which read phisigma at neighboring cells and so must not run in the same sweep.
+	//Passes pass0 <= pass < pass1 are run, so a tiled caller can order them across slabs.
+	for(int pass = pass0; pass < pass1; pass++){
+		for(int blk = 0; blk < U.n; blk++){
+			const int* up = U.up[blk];
+			double swap[3];
+			for(int d = 0; d < 3; d++){swap[d] = up[d] ? -1. : 1.;}
+
+			for(int vx = U.lo[blk][0]; vx < U.hi[blk][0]; vx++){
+				for(int vy = U.lo[blk][1]; vy < U.hi[blk][1]; vy++){
+					for(int vz = U.lo[blk][2]; vz < U.hi[blk][2]; vz++){
+						for(int k = lo[2]; k < hi[2]; k++){
+							for(int j = lo[1]; j < hi[1]; j++){
+								for(int i = lo[0]; i < hi[0]; i++){
+
+									int sidx = i + Nx*j + Nx*Ny*k;
 
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-
-				int sidx = i + Nx*j + Nx*Ny*k;
-
-				double xC[3] = {mesh[sidx].x,  mesh[sidx].y,  mesh[sidx].z};
-				double sC[3] = {mesh[sidx].dx,  mesh[sidx].dy,  mesh[sidx].dz};
-
-				for(int vx = 0; vx < NV[0]; vx++){
-					for(int vy = 0; vy < NV[1]; vy++){
-						for(int vz = 0; vz < NV[2]; vz++){
+									double xC[3] = {mesh[sidx].x,  mesh[sidx].y,  mesh[sidx].z};
+									double sC[3] = {mesh[sidx].dx,  mesh[sidx].dy,  mesh[sidx].dz};
 
 
-							//Compute Sigma
-							int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+									//Compute Sigma
+									int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 
 							
 
-							for(int Dim = 0; Dim < effD; Dim++){
-								int IL, IR, JL, JR, KL, KR;
+									for(int Dim = 0; Dim < effD; Dim++){
+										int IL, IR, JL, JR, KL, KR;
 
-								//Periodic Boundary Conditions
-								if(Dim == 0 && BCs[0] == 0){IL = (i - 1 + N[0])%N[0]; IR = (i + 1)%N[0]; JL = j; JR = j; KL = k; KR = k;} 
-								if(Dim == 1 && BCs[1] == 0){JL = (j - 1 + N[1])%N[1]; JR = (j + 1)%N[1]; IL = i; IR = i; KL = k; KR = k;}
-								if(Dim == 2 && BCs[2] == 0){KL = (k - 1 + N[2])%N[2]; KR = (k + 1)%N[2]; IL = i; IR = i; JL = j; JR = j;}
+										//Periodic Boundary Conditions
+										if(Dim == 0 && BCs[0] == 0){IL = (i - 1 + N[0])%N[0]; IR = (i + 1)%N[0]; JL = j; JR = j; KL = k; KR = k;} 
+										if(Dim == 1 && BCs[1] == 0){JL = (j - 1 + N[1])%N[1]; JR = (j + 1)%N[1]; IL = i; IR = i; KL = k; KR = k;}
+										if(Dim == 2 && BCs[2] == 0){KL = (k - 1 + N[2])%N[2]; KR = (k + 1)%N[2]; IL = i; IR = i; JL = j; JR = j;}
 
 
-								//Dirichlet Boundary Conditions
-								if(Dim == 0 && BCs[0] == 1){IL = (i - 1); IR = (i + 1); if(IL < 0){IL = 0;} if(IR == N[0]){IR = N[0] - 1;} JL = j; JR = j; KL = k; KR = k;} 
-								if(Dim == 1 && BCs[1] == 1){JL = (j - 1); JR = (j + 1); if(JL < 0){JL = 0;} if(JR == N[1]){JR = N[1] - 1;} IL = i; IR = i; KL = k; KR = k;}
-								if(Dim == 2 && BCs[2] == 1){KL = (k - 1); KR = (k + 1); if(KL < 0){KL = 0;} if(KR == N[2]){KR = N[2] - 1;} IL = i; IR = i; JL = j; JR = j;}
+										//Dirichlet Boundary Conditions
+										if(Dim == 0 && BCs[0] == 1){IL = (i - 1); IR = (i + 1); if(IL < 0){IL = 0;} if(IR == N[0]){IR = N[0] - 1;} JL = j; JR = j; KL = k; KR = k;} 
+										if(Dim == 1 && BCs[1] == 1){JL = (j - 1); JR = (j + 1); if(JL < 0){JL = 0;} if(JR == N[1]){JR = N[1] - 1;} IL = i; IR = i; KL = k; KR = k;}
+										if(Dim == 2 && BCs[2] == 1){KL = (k - 1); KR = (k + 1); if(KL < 0){KL = 0;} if(KR == N[2]){KR = N[2] - 1;} IL = i; IR = i; JL = j; JR = j;}
 								
 								
-								//Neumann Boundary Conditions
-								if(Dim == 0 && BCs[0] == 2){IL = (i - 1); IR = (i + 1); if(IL < 0){IL = 0;} if(IR == N[0]){IR = N[0] - 1;} JL = j; JR = j; KL = k; KR = k;} 
-								if(Dim == 1 && BCs[1] == 2){JL = (j - 1); JR = (j + 1); if(JL < 0){JL = 0;} if(JR == N[1]){JR = N[1] - 1;} IL = i; IR = i; KL = k; KR = k;}
-								if(Dim == 2 && BCs[2] == 2){KL = (k - 1); KR = (k + 1); if(KL < 0){KL = 0;} if(KR == N[2]){KR = N[2] - 1;} IL = i; IR = i; JL = j; JR = j;}
+										//Neumann Boundary Conditions
+										if(Dim == 0 && BCs[0] == 2){IL = (i - 1); IR = (i + 1); if(IL < 0){IL = 0;} if(IR == N[0]){IR = N[0] - 1;} JL = j; JR = j; KL = k; KR = k;} 
+										if(Dim == 1 && BCs[1] == 2){JL = (j - 1); JR = (j + 1); if(JL < 0){JL = 0;} if(JR == N[1]){JR = N[1] - 1;} IL = i; IR = i; KL = k; KR = k;}
+										if(Dim == 2 && BCs[2] == 2){KL = (k - 1); KR = (k + 1); if(KL < 0){KL = 0;} if(KR == N[2]){KR = N[2] - 1;} IL = i; IR = i; JL = j; JR = j;}
 								
-								//Gather Left and Right Indices in real/vel space
-								int idxL = IL + Nx*JL + Nx*Ny*KL + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-								int idxR = IR + Nx*JR + Nx*Ny*KR + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+										//Gather Left and Right Indices in real/vel space
+										int idxL = IL + Nx*JL + Nx*Ny*KL + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+										int idxR = IR + Nx*JR + Nx*Ny*KR + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 
-								//Gather Left and Right Spacial Indices
-								int sidxL = IL + Nx*JL + Nx*Ny*KL;
-								int sidxR = IR + Nx*JR + Nx*Ny*KR;
+										//Gather Left and Right Spacial Indices
+										int sidxL = IL + Nx*JL + Nx*Ny*KL;
+										int sidxR = IR + Nx*JR + Nx*Ny*KR;
 								
 
-								//Gather position of left/right cell centers
-								double xL[3] = {mesh[sidxL].x, mesh[sidxL].y, mesh[sidxL].z};
-								double xR[3] = {mesh[sidxR].x, mesh[sidxR].y, mesh[sidxR].z};
+										//Gather position of left/right cell centers
+										double xL[3] = {mesh[sidxL].x, mesh[sidxL].y, mesh[sidxL].z};
+										double xR[3] = {mesh[sidxR].x, mesh[sidxR].y, mesh[sidxR].z};
 								
-								//Gather cell size of left/right cells
-								double sL[3] = {mesh[sidxL].dx, mesh[sidxL].dy, mesh[sidxL].dz};
-								double sR[3] = {mesh[sidxR].dx, mesh[sidxR].dy, mesh[sidxR].dz};
+										//Gather cell size of left/right cells
+										double sL[3] = {mesh[sidxL].dx, mesh[sidxL].dy, mesh[sidxL].dz};
+										double sR[3] = {mesh[sidxR].dx, mesh[sidxR].dy, mesh[sidxR].dz};
 								
 
-								//Computing phisigma, at cell 
-								gsigma[effD*idx + Dim] = VanLeer(gbarp[idxL], gbarp[idx], gbarp[idxR], xL[Dim], xC[Dim], xR[Dim]);
-								bsigma[effD*idx + Dim] = VanLeer(bbarp[idxL], bbarp[idx], bbarp[idxR], xL[Dim], xC[Dim], xR[Dim]);
+										//Computing phisigma, at cell 
+										if(pass == 0){
+											gsigma[effD*idx + Dim] = LimitedSlope<LIM>(gbarp[idxL], gbarp[idx], gbarp[idxR], xL[Dim], xC[Dim], xR[Dim], rh[Dim]);
+											bsigma[effD*idx + Dim] = LimitedSlope<LIM>(bbarp[idxL], bbarp[idx], bbarp[idxR], xL[Dim], xC[Dim], xR[Dim], rh[Dim]);
+											continue;
+										}
 
-								//printf("Checking bsigma input[%d][%d]: bbarp[idxL] = %f, bbarp[idx] = %f, bbarp[idxR] = %f, xL[Dim] = %f, xC[Dim] = %f, xR[Dim] = %f\n", sidx, vx, bbarp[idxL], bbarp[idx], bbarp[idxR], xL[Dim], xC[Dim], xR[Dim]);
+										//printf("Checking bsigma input[%d][%d]: bbarp[idxL] = %f, bbarp[idx] = %f, bbarp[idxR] = %f, xL[Dim] = %f, xC[Dim] = %f, xR[Dim] = %f\n", sidx, vx, bbarp[idxL], bbarp[idx], bbarp[idxR], xL[Dim], xC[Dim], xR[Dim]);
 
 								
 
-								//Computing phisigma, at interface
-								for(int Dim2 = 0; Dim2 < effD; Dim2++){
+										//Computing phisigma, at interface
+										for(int Dim2 = 0; Dim2 < effD; Dim2++){
 
-									int IL2, IR2, JL2, JR2, KL2, KR2;
+											int IL2, IR2, JL2, JR2, KL2, KR2;
 
-									//Periodic Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 0){IL2 = (i - 1 + N[0])%N[0]; IR2 = (i + 1)%N[0]; JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 0){JL2 = (j - 1 + N[1])%N[1]; JR2 = (j + 1)%N[1]; IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 0){KL2 = (k - 1 + N[2])%N[2]; KR2 = (k + 1)%N[2]; IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
+											//Periodic Boundary Conditions
+											if(Dim2 == 0 && BCs[0] == 0){IL2 = (i - 1 + N[0])%N[0]; IR2 = (i + 1)%N[0]; JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+											if(Dim2 == 1 && BCs[1] == 0){JL2 = (j - 1 + N[1])%N[1]; JR2 = (j + 1)%N[1]; IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+											if(Dim2 == 2 && BCs[2] == 0){KL2 = (k - 1 + N[2])%N[2]; KR2 = (k + 1)%N[2]; IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 	
 									
-									//Dirichlet Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 1){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 1){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 1){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
+											//Dirichlet Boundary Conditions
+											if(Dim2 == 0 && BCs[0] == 1){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+											if(Dim2 == 1 && BCs[1] == 1){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+											if(Dim2 == 2 && BCs[2] == 1){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 
 
-									//Neumann Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 2){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 2){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 2){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
+											//Neumann Boundary Conditions
+											if(Dim2 == 0 && BCs[0] == 2){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+											if(Dim2 == 1 && BCs[1] == 2){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+											if(Dim2 == 2 && BCs[2] == 2){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 
 
-									int idxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-									int idxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+											int idxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+											int idxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 
-									int sidxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2;
-									int sidxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2;
+											int sidxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2;
+											int sidxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2;
 									
 
-									double xL2[3] = {mesh[sidxL2].x, mesh[sidxL2].y, mesh[sidxL2].z};
-									double xR2[3] = {mesh[sidxR2].x, mesh[sidxR2].y, mesh[sidxR2].z};
-									double xC[3] = {mesh[sidx].x,  mesh[sidx].y,  mesh[sidx].z};
+											double xL2[3] = {mesh[sidxL2].x, mesh[sidxL2].y, mesh[sidxL2].z};
+											double xR2[3] = {mesh[sidxR2].x, mesh[sidxR2].y, mesh[sidxR2].z};
+											double xC[3] = {mesh[sidx].x,  mesh[sidx].y,  mesh[sidx].z};
 
-									//printf("sidx = %d, sidxL2 = %d, sidxR2 = %d\n", sidx, sidxL2, sidxR2);
-									//printf("xL2 = {%f, %f, %f}\n", xL2[0], xL2[1], xL2[2]);
-									//printf("xC = {%f, %f, %f}\n", xC[0], xC[1], xC[2]);
+											//printf("sidx = %d, sidxL2 = %d, sidxR2 = %d\n", sidx, sidxL2, sidxR2);
+											//printf("xL2 = {%f, %f, %f}\n", xL2[0], xL2[1], xL2[2]);
+											//printf("xC = {%f, %f, %f}\n", xC[0], xC[1], xC[2]);
 
-									double sL2[3] = {mesh[sidxL2].dx, mesh[sidxL2].dy, mesh[sidxL2].dz};
-									double sR2[3] = {mesh[sidxR2].dx, mesh[sidxR2].dy, mesh[sidxR2].dz};
-									double sC2[3] = {mesh[sidx].dx,  mesh[sidx].dy,  mesh[sidx].dz};
+											double sL2[3] = {mesh[sidxL2].dx, mesh[sidxL2].dy, mesh[sidxL2].dz};
+											double sR2[3] = {mesh[sidxR2].dx, mesh[sidxR2].dy, mesh[sidxR2].dz};
+											double sC2[3] = {mesh[sidx].dx,  mesh[sidx].dy,  mesh[sidx].dz};
 
 
-									//Dim 1 is vector component that is being interpolated.
-									//Dim 2 is direction of interpolation.
+											//Dim 1 is vector component that is being interpolated.
+											//Dim 2 is direction of interpolation.
 
-									gsigma2[effD*effD*idx + effD*Dim + Dim2] = gsigma[effD*idx + Dim] + (sC2[Dim2]/2)*VanLeer(gsigma[effD*idxL2 + Dim], gsigma[effD*idx + Dim], gsigma[effD*idxR2 + Dim], xL2[Dim2], xC[Dim2], xR2[Dim2]);
-									bsigma2[effD*effD*idx + effD*Dim + Dim2] = bsigma[effD*idx + Dim] + (sC2[Dim2]/2)*VanLeer(bsigma[effD*idxL2 + Dim], bsigma[effD*idx + Dim], bsigma[effD*idxR2 + Dim], xL2[Dim2], xC[Dim2], xR2[Dim2]);
+											gsigma2[effD*effD*idx + effD*Dim + Dim2] = gsigma[effD*idx + Dim] + (sC2[Dim2]/2)*LimitedSlope<LIM>(gsigma[effD*idxL2 + Dim], gsigma[effD*idx + Dim], gsigma[effD*idxR2 + Dim], xL2[Dim2], xC[Dim2], xR2[Dim2], rh[Dim2]);
+											bsigma2[effD*effD*idx + effD*Dim + Dim2] = bsigma[effD*idx + Dim] + (sC2[Dim2]/2)*LimitedSlope<LIM>(bsigma[effD*idxL2 + Dim], bsigma[effD*idx + Dim], bsigma[effD*idxR2 + Dim], xL2[Dim2], xC[Dim2], xR2[Dim2], rh[Dim2]);
 									
-									//printf("xL2[%d], xC[%d], xR2[%d] = %f, %f, %f\n", Dim2, Dim2, Dim2, xL2[Dim2], xC[Dim2], xR2[Dim2]);
-									//printf("sidx = %d, gbarp[%d] = %f\n", sidx, idxR, gbarp[idxR]);
-									//printf("gsigma = %f\n" ,gsigma[effD*idx + Dim]);
-									//printf("gsigma2 = %f\n",gsigma2[effD*effD*idx + effD*Dim + Dim2]);
+											//printf("xL2[%d], xC[%d], xR2[%d] = %f, %f, %f\n", Dim2, Dim2, Dim2, xL2[Dim2], xC[Dim2], xR2[Dim2]);
+											//printf("sidx = %d, gbarp[%d] = %f\n", sidx, idxR, gbarp[idxR]);
+											//printf("gsigma = %f\n" ,gsigma[effD*idx + Dim]);
+											//printf("gsigma2 = %f\n",gsigma2[effD*effD*idx + effD*Dim + Dim2]);
 									
-								}
+										}
 
 
-								//Dot Product is just a single product when using rectangular mesh
-								int interpidx = idx;
-								double swap = 1.;
-								     if(Co_X[vx] < 0 && Dim == 0){interpidx = idxR; swap = -1;}
-								else if(Co_Y[vy] < 0 && Dim == 1){interpidx = idxR; swap = -1;}
-								else if(Co_Z[vz] < 0 && Dim == 2){interpidx = idxR; swap = -1;}
+										//Dot Product is just a single product when using rectangular mesh
+										//Upwind cell is the right neighbor for a negative velocity along Dim, fixed for the block
+										int interpidx = up[Dim] ? idxR : idx;
 
 								
-								//TODO need to change sC to sR when swap, doesnt currently matter for sod bc dx_i = dx_0
-								gbarpbound[effD*idx + Dim] = gbarp[interpidx] + swap*sC[Dim]/2*gsigma[effD*interpidx + Dim];
-								bbarpbound[effD*idx + Dim] = bbarp[interpidx] + swap*sC[Dim]/2*bsigma[effD*interpidx + Dim];
+										//TODO need to change sC to sR when swap, doesnt currently matter for sod bc dx_i = dx_0
+										gbarpbound[effD*idx + Dim] = gbarp[interpidx] + swap[Dim]*sC[Dim]/2*gsigma[effD*interpidx + Dim];
+										bbarpbound[effD*idx + Dim] = bbarp[interpidx] + swap[Dim]*sC[Dim]/2*bsigma[effD*interpidx + Dim];
 
-								//printf("Checking bbarpbound[%d][%d]: bbarp = %f, bsigma = %f\n", sidx,vx, bbarp[interpidx], bsigma[effD*interpidx + Dim]);
-								assert(gbarpbound[effD*idx + Dim] == gbarpbound[effD*idx + Dim]); // NaN Checker
-								assert(bbarpbound[effD*idx + Dim] == bbarpbound[effD*idx + Dim]); // NaN Checker
+										//printf("Checking bbarpbound[%d][%d]: bbarp = %f, bsigma = %f\n", sidx,vx, bbarp[interpidx], bsigma[effD*interpidx + Dim]);
 
 								
+									}
+								}
 							}
 						}
 					}
 				}
 			}
 		}
-	}
 
+	}
 }
 
 
 // Step 1c: Compute phibar at interface by interpolating w/ phisigma2, x-Xi*dt/2
-void Step1c(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma2, double* bsigma2, double dt, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+template <int D, int BCX, int BCY, int BCZ> static void Step1cK(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma2, double* bsigma2, double dt, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int s0, int s1){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+	constexpr int BCs[3] = {BCX, BCY, BCZ};
+
 
 	if(debug == 1){printf("Entering Step 1c\n");}
 
@@ -287,59 +351,58 @@ void Step1c(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, d
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
+	UpwindBlocks U;
+	SplitUpwind(&U, Co_X, Co_Y, Co_Z, NV, effD);
+
+	for(int blk = 0; blk < U.n; blk++){
+		const int* up = U.up[blk];
+		for(int vx = U.lo[blk][0]; vx < U.hi[blk][0]; vx++){
+			for(int vy = U.lo[blk][1]; vy < U.hi[blk][1]; vy++){
+				for(int vz = U.lo[blk][2]; vz < U.hi[blk][2]; vz++){
+					double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+					for(int k = lo[2]; k < hi[2]; k++){
+						for(int j = lo[1]; j < hi[1]; j++){
+							for(int i = lo[0]; i < hi[0]; i++){
+								int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+								for(int Dim = 0; Dim < effD; Dim++){
 
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-				for(int vx = 0; vx < NV[0]; vx++){
-					for(int vy = 0; vy < NV[1]; vy++){
-						for(int vz = 0; vz < NV[2]; vz++){
-							int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-							for(int Dim = 0; Dim < effD; Dim++){
-
-								double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
-
-								//Phibar at Interface, at t = n+1/2
-								gbar[effD*idx + Dim] = gbarpbound[effD*idx + Dim];
-								bbar[effD*idx + Dim] = bbarpbound[effD*idx + Dim];
+									//Phibar at Interface, at t = n+1/2
+									gbar[effD*idx + Dim] = gbarpbound[effD*idx + Dim];
+									bbar[effD*idx + Dim] = bbarpbound[effD*idx + Dim];
 
 
-								for(int Dim2 = 0; Dim2 < effD; Dim2++){
+									for(int Dim2 = 0; Dim2 < effD; Dim2++){
 
-									int IL2, IR2, JL2, JR2, KL2, KR2;
-									//Periodic Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 0){IL2 = (i - 1 + N[0])%N[0]; IR2 = (i + 1)%N[0]; JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 0){JL2 = (j - 1 + N[1])%N[1]; JR2 = (j + 1)%N[1]; IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 0){KL2 = (k - 1 + N[2])%N[2]; KR2 = (k + 1)%N[2]; IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
+										int IL2, IR2, JL2, JR2, KL2, KR2;
+										//Periodic Boundary Conditions
+										if(Dim2 == 0 && BCs[0] == 0){IL2 = (i - 1 + N[0])%N[0]; IR2 = (i + 1)%N[0]; JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+										if(Dim2 == 1 && BCs[1] == 0){JL2 = (j - 1 + N[1])%N[1]; JR2 = (j + 1)%N[1]; IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+										if(Dim2 == 2 && BCs[2] == 0){KL2 = (k - 1 + N[2])%N[2]; KR2 = (k + 1)%N[2]; IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 	
 									
-									//Dirichlet Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 1){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 1){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 1){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
-
+										//Dirichlet Boundary Conditions
+										if(Dim2 == 0 && BCs[0] == 1){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+										if(Dim2 == 1 && BCs[1] == 1){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+										if(Dim2 == 2 && BCs[2] == 1){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 
-									//Neumann Boundary Conditions
-									if(Dim2 == 0 && BCs[0] == 2){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
-									if(Dim2 == 1 && BCs[1] == 2){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
-									if(Dim2 == 2 && BCs[2] == 2){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 
+										//Neumann Boundary Conditions
+										if(Dim2 == 0 && BCs[0] == 2){IL2 = (i - 1); IR2 = (i + 1); if(IL2 < 0){IL2 = 0;} if(IR2 == N[0]){IR2 = N[0] - 1;} JL2 = j; JR2 = j; KL2 = k; KR2 = k;} 
+										if(Dim2 == 1 && BCs[1] == 2){JL2 = (j - 1); JR2 = (j + 1); if(JL2 < 0){JL2 = 0;} if(JR2 == N[1]){JR2 = N[1] - 1;} IL2 = i; IR2 = i; KL2 = k; KR2 = k;}
+										if(Dim2 == 2 && BCs[2] == 2){KL2 = (k - 1); KR2 = (k + 1); if(KL2 < 0){KL2 = 0;} if(KR2 == N[2]){KR2 = N[2] - 1;} IL2 = i; IR2 = i; JL2 = j; JR2 = j;}
 
-									int idxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-									int idxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 
-									int interpidx = idx;
-									double swap = 1.;
-								         if(Co_X[vx] < 0 && Dim2 == 0){interpidx = idxR2; swap = -1;}
-									else if(Co_Y[vy] < 0 && Dim2 == 1){interpidx = idxR2; swap = -1;}
-									else if(Co_Z[vz] < 0 && Dim2 == 2){interpidx = idxR2; swap = -1;}
+										int idxL2 = IL2 + Nx*JL2 + Nx*Ny*KL2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+										int idxR2 = IR2 + Nx*JR2 + Nx*Ny*KR2 + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 
-									gbar[effD*idx + Dim] -= dt/2.0*Xi[Dim2]*gsigma2[effD*effD*interpidx + effD*Dim2 + Dim];
-									bbar[effD*idx + Dim] -= dt/2.0*Xi[Dim2]*bsigma2[effD*effD*interpidx + effD*Dim2 + Dim];
+										int interpidx = up[Dim2] ? idxR2 : idx;
 
-									assert(gbar[effD*idx + Dim] == gbar[effD*idx + Dim]); // NaN Checker
-									assert(bbar[effD*idx + Dim] == bbar[effD*idx + Dim]); // NaN Checker
-								}	
+										gbar[effD*idx + Dim] -= dt/2.0*Xi[Dim2]*gsigma2[effD*effD*interpidx + effD*Dim2 + Dim];
+										bbar[effD*idx + Dim] -= dt/2.0*Xi[Dim2]*bsigma2[effD*effD*interpidx + effD*Dim2 + Dim];
+									}	
+								}
 							}
 						}
 					}
@@ -351,97 +414,53 @@ void Step1c(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, d
 
 //Step 2: Microflux
 //Step 2a: Interpolate W to interface.
-void Step2a(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, double* Co_WX, double* Co_WY, double* Co_WZ, double dt, double* rhoh, double* rhovh, double* rhoEh, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+void Step2a(double* gbar, double* bbar, MomentBasis* M, Source* S, double dt, double* rhoh, double* rhovh, double* rhoEh, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, int s0, int s1, double* gm, double* tree){
 	
 	if(debug == 1){printf("Entering Step 2a\n");}
 	
-	int Nx = N[0];
-	int Ny = N[1];
-	int Nz = N[2];
-
-
-	//Compute conserved variables W at t+1/2
-	//First do density at boundary, density is needed for others.
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-				int sidx = i + Nx*j + Nx*Ny*k;
-				for(int d = 0; d < effD; d++){
-
-					rhoh[effD*sidx + d] = 0; 
-
-					for(int vx = 0; vx < NV[0]; vx++){
-						for(int vy = 0; vy < NV[1]; vy++){
-							for(int vz = 0; vz < NV[2]; vz++){
-
-
-								int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-
-								rhoh[effD*sidx + d] += Co_WX[vx]*Co_WY[vy]*Co_WZ[vz]*gbar[effD*idx + d]; 
-							}
-						}
-					}
-				}
-			}
-		}
-	}
-
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-				int sidx = i + Nx*j + Nx*Ny*k;
-				//Inialize E and momentum with source term
-				
-				//Dim is vector component that was interpolated
-				//Dim2 is direction of interpolation (toward interface)
-				for(int Dim2 = 0; Dim2 < effD; Dim2++){
-
-					rhoEh[effD*sidx + Dim2] = 0.0;  // Initialize 0 before effD dot product.
-
-					for(int Dim = 0; Dim < effD; Dim++){
+	int Nc = N[0]*N[1]*N[2];
+	int Ncols = Nc*effD; // Column c = effD*sidx + Dim2 of gbar/bbar
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
 
-						rhovh[effD*effD*sidx + effD*Dim + Dim2] = dt/2*rhoh[effD*sidx+Dim2]*0; //TODO: In future, replace 0 with acceleration field
-						rhoEh[effD*sidx + Dim2] += dt/2.*rhoh[effD*sidx + Dim]*0; //TODO: In future replace 0 with u.dot(a), vel dot acc
-					}
-
-				}
-
-				for(int vx = 0; vx < NV[0]; vx++){
-					for(int vy = 0; vy < NV[1]; vy++){
-						for(int vz = 0; vz < NV[2]; vz++){
+	//Compute conserved variables W at t+1/2, all interface directions in one pass
+	//Rows of gm: density, then momentum component Dim
+	MomentsCols(M, gbar, Ncols, effD*c0, effD*c1, MOM_RHO, 1 + effD, gm, tree);
+	MomentsCols(M, bbar, Ncols, effD*c0, effD*c1, MOM_RHO, 1, rhoEh, tree);
 
-							int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+	for(int sidx = c0; sidx < c1; sidx++){
 
-							double U[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
-
-							//Dim is vector component that was interpolated
-							//Dim2 is direction of interpolation (toward interface)
-							for(int Dim2 = 0; Dim2 < effD; Dim2++){
-								for(int Dim = 0; Dim < effD; Dim++){
+		//Dim is vector component that was interpolated
+		//Dim2 is direction of interpolation (toward interface)
+		for(int Dim2 = 0; Dim2 < effD; Dim2++){
 
-									rhovh[effD*effD*sidx + effD*Dim + Dim2] += Co_WX[vx]*Co_WY[vy]*Co_WZ[vz]*U[Dim]*gbar[effD*idx + Dim2]; 
-									
-								}
+			int col = effD*sidx + Dim2;
+			rhoh[col] = gm[MOM_RHO*Ncols + col];
 
-								rhoEh[effD*sidx + Dim2] += Co_WX[vx]*Co_WY[vy]*Co_WZ[vz]*bbar[effD*idx + Dim2]; 
-							}	
-						}
-					}
-				}
+			//Half a step of the sources: momentum gains rho*a, energy rho*u.a + Q
+			for(int Dim = 0; Dim < effD; Dim++){
+				rhovh[effD*effD*sidx + effD*Dim + Dim2] = gm[(MOM_XI + Dim)*Ncols + col] + dt/2*rhoh[col]*S->a[effD*sidx + Dim];
+				rhoEh[col] += dt/2.*gm[(MOM_XI + Dim)*Ncols + col]*S->a[effD*sidx + Dim];
 			}
+			rhoEh[col] += dt/2.*S->Q[sidx];
 		}
 	}
 }
 
 //Step 2b: compute original phi at interface using gbar, W at interface
 //Memory Recycling: phibar @ interface is used to store phi @ interface.
-void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh, double* rhoEh, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+template <int D> static void Step2bK(double* gbar, double* bbar, Source* S, double dt, double* rhoh, double* rhovh, double* rhoEh, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int s0, int s1){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+
 
 	if(debug == 1){printf("Entering Step 2b\n");}
 
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
 
 	double tg;
 	double tb;
@@ -452,9 +471,9 @@ void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh,
 	double g_eq;
 	double b_eq;
 
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
+	for(int i = lo[0]; i < hi[0]; i++){
+		for(int j = lo[1]; j < hi[1]; j++){
+			for(int k = lo[2]; k < hi[2]; k++){
 				sidx = i + Nx*j + Nx*Ny*k;
 				for(int dim2 = 0; dim2 < effD; dim2++){ 
 
@@ -465,11 +484,6 @@ void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh,
 					T = Temperature(rhoEh[effD*sidx+ dim2]/rhoh[effD*sidx + dim2], u);
 
 
-					if(T < 0){printf("rhoEh[effD*sidx+ dim2] = %f, rhoh[effD*sidx + dim2] = %f, u = %f\n", rhoEh[effD*sidx+ dim2], rhoh[effD*sidx + dim2], u);}
-					assert(u > 0);
-					assert(T > 0);
-
-
 					tg = visc(T)/rhoh[effD*sidx + dim2]/R/T;
 					tb = tg/Pr;
 
@@ -484,15 +498,21 @@ void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh,
 								double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
 
 								for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhovh[effD*effD*sidx + effD*dim + dim2]/rhoh[effD*sidx + dim2])*(Xi[dim]-rhovh[effD*effD*sidx + effD*dim + dim2]/rhoh[effD*sidx + dim2]);} //TODO: Potential BUG, did not double check algebra or access dim order
-								assert(c2 > 0);
-
 
 								g_eq = geq(c2, rhoh[effD*sidx + dim2], T);
 								b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
 
+								double Sg = 0.;
+								double Sb = 0.;
+								if(S->on){
+									double U[3];
+									for(int dim = 0; dim < effD; dim++){U[dim] = rhovh[effD*effD*sidx + effD*dim + dim2]/rhoh[effD*sidx + dim2];}
+									SourceVelocity(effD, S->a + effD*sidx, S->Q[sidx], Xi, U, rhoh[effD*sidx + dim2], T, R, g_eq, &Sg, &Sb);
+								}
+
 								// this is actually the original distribution function, recycling memory from gbar
-								gbar[effD*idx + dim2] = 2*tg/(2*tg + dt/2.)*gbar[effD*idx + dim2] + dt/(4*tg + dt)*g_eq + dt*tg/(4*tg + dt)*0; //TODO replace this last *0 with source term 
-								bbar[effD*idx + dim2] = 2*tb/(2*tb + dt/2.)*bbar[effD*idx + dim2] + dt/(4*tb + dt)*b_eq + dt*tb/(4*tb + dt)*0; //TODO replace this last *0 with source term
+								gbar[effD*idx + dim2] = 2*tg/(2*tg + dt/2.)*gbar[effD*idx + dim2] + dt/(4*tg + dt)*g_eq + dt*tg/(4*tg + dt)*Sg;
+								bbar[effD*idx + dim2] = 2*tb/(2*tb + dt/2.)*bbar[effD*idx + dim2] + dt/(4*tb + dt)*b_eq + dt*tb/(4*tb + dt)*Sb;
 							}
 						}
 					}
@@ -503,20 +523,26 @@ void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh,
 }
 
 //Step 2c: Compute Microflux F at interface at half timestep using W/phi at interface.
-void Step2c(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, Cell* mesh, double* Fg, double* Fb, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+template <int D, int BCX, int BCY, int BCZ> static void Step2cK(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, Cell* mesh, double* Fg, double* Fb, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int s0, int s1){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+	constexpr int BCs[3] = {BCX, BCY, BCZ};
+
 	
 	if(debug == 1){printf("Entering Step 2c\n");}
 
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
 
 	int sidx;
 	int idx;
 	
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
+	for(int i = lo[0]; i < hi[0]; i++){
+		for(int j = lo[1]; j < hi[1]; j++){
+			for(int k = lo[2]; k < hi[2]; k++){
 
 				//Spatial Index
 				sidx = i + Nx*j + Nx*Ny*k;
@@ -575,98 +601,161 @@ void Step2c(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z
 }
 
 //Step 3: Source Terms
-void Step3(){
+//Evaluated once per cell per step: the net heating rate Q from W at the start of the step (the acceleration is static).
+//The kernels build the per velocity sources from Q, a and their local equilibrium.
+void Step3(Source* S, double* rho, double* rhov, double* rhoE, int* N, int effD, int s0, int s1){
+
+	if(S->on == 0){return;}
 
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
 
+	for(int sidx = c0; sidx < c1; sidx++){
+		double u = 0;
+		for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} u = sqrt(u);
+		S->T[sidx] = Temperature(rhoE[sidx]/rho[sidx], u);
+	}
+	SourceRate(S, rho + c0, S->T + c0, S->Q + c0, c1 - c0);
 }
 
 //Step 4: Update Conservative Variables W at cell center at next timestep
 //Step 5: Update Phi at cell center at next time step
-void Step4and5(double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, double* Fg, double* Fb, double* Co_X, double* Co_Y, double* Co_Z, double* Co_WX, double* Co_WY, double* Co_WZ, double* g, double* b, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+//Same ordering as the Regent solver: terms with the old W/tau first, then W from the moments of the flux, then terms with the new W/tau.
+template <int D, int BCX, int BCY, int BCZ> static void Step4and5K(double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, double* Fg, double* Fb, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, Source* S, double* g, double* b, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NVin, int s0, int s1, double* Fm, double* tree){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+	constexpr int BCs[3] = {BCX, BCY, BCZ};
+
 
 	if(debug == 1){printf("Entering Step 4 & 5\n");}
 
 	int Nx = N[0];
 	int Ny = N[1];
 	int Nz = N[2];
-
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
+	int lo[3], hi[3], c0, c1;
+	Slab(effD, s0, s1, N, lo, hi, &c0, &c1);
+	int Nc = Nx*Ny*Nz;
+
+	//Step 5, first half: explicit terms with old eq's and taus
+	for(int i = lo[0]; i < hi[0]; i++){
+		for(int j = lo[1]; j < hi[1]; j++){
+			for(int k = lo[2]; k < hi[2]; k++){
 	
 				int sidx = i + Nx*j + Nx*Ny*k;
 
+				if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) ||
+				   (BCs[1] == 1 && j == 0) || (BCs[1] == 1 && j == N[1] - 1) ||
+				   (BCs[2] == 1 && k == 0) || (BCs[2] == 1 && k == N[2] - 1)){continue;} // Dirichlet: no change
+
 				double V = mesh[sidx].dx*mesh[sidx].dy*mesh[sidx].dz;
 
-				double rhotest = 0;
+				//Compute Flow velocity uo and temperature To before updating W
+				double uo = 0; //old flow velocity
+				for(int dim = 0; dim < effD; dim++){uo += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} uo = sqrt(uo);
+				double To = Temperature(rhoE[sidx]/rho[sidx], uo); //old temp
+				//Compute old taus
+				double tgo = visc(To)/rho[sidx]/R/To; // tau = mu/P, P = rho*R*T.
+				double tbo = tgo/Pr; 
+
 				for(int vx = 0; vx < NV[0]; vx++){
 					for(int vy = 0; vy < NV[1]; vy++){
 						for(int vz = 0; vz < NV[2]; vz++){
-							
-							
 
 							int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
 							double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
 
-							//Compute Flow velocity uo and temperature To before updating rho
-							double uo = 0; //old flow velocity
-							for(int dim = 0; dim < effD; dim++){uo += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} uo = sqrt(uo);
-							double To = Temperature(rhoE[sidx]/rho[sidx], uo); //old temp
-							//Compute old taus
-							double tgo = visc(To)/rho[sidx]/R/To; // tau = mu/P, P = rho*R*T.
-							double tbo = tgo/Pr; 
-
 							//Compute old eq's
 							double c2 = 0;
-							for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);} //TODO: Potential BUG, did not double check algebra.
+							for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);}
 							double g_eqo = geq(c2, rho[sidx],To);
 							double b_eqo = g_eqo*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*To)/2;
 
-
-							//Step 4: Update W at cell center
-							rho[sidx] += -(dt/V*Fg[idx] + dt*0)*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz]; //TODO replace 0 with source term.
-							for(int dim = 0; dim < effD; dim++){
-								rhov[effD*sidx + dim] += -dt/V*Fg[idx]*Xi[dim]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
+							double Sg = 0.;
+							double Sb = 0.;
+							if(S->on){
+								double U[3];
+								for(int dim = 0; dim < effD; dim++){U[dim] = rhov[effD*sidx + dim]/rho[sidx];}
+								SourceVelocity(effD, S->a + effD*sidx, S->Q[sidx], Xi, U, rho[sidx], To, R, g_eqo, &Sg, &Sb);
 							}
 
-							rhoE[sidx] += -dt/V*Fb[idx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
+							g[idx] = g[idx] + dt/2*(g_eqo-g[idx])/tgo - dt/V*Fg[idx] + dt*Sg;
+							b[idx] = b[idx] + dt/2*(b_eqo-b[idx])/tbo - dt/V*Fb[idx] + dt*Sb;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Step 4: Update W at cell center from the moments of the flux
+	//Fm rows: mass and momentum flux, then energy flux
+	MomentsCols(M, Fg, Nc, c0, c1, MOM_RHO, 1 + effD, Fm, tree);
+	MomentsCols(M, Fb, Nc, c0, c1, MOM_RHO, 1, Fm + (1+effD)*Nc, tree);
+
+	for(int sidx = c0; sidx < c1; sidx++){
+
+		double V = mesh[sidx].dx*mesh[sidx].dy*mesh[sidx].dz;
+
+		//Moments of the sources (none in Dirichlet boundary cells, whose g is not updated)
+		int i = sidx%Nx, j = (sidx/Nx)%Ny, k = sidx/(Nx*Ny);
+		double Srhov[3] = {0, 0, 0};
+		double SrhoE = 0;
+		if(S->on && !((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) ||
+		              (BCs[1] == 1 && j == 0) || (BCs[1] == 1 && j == N[1] - 1) ||
+		              (BCs[2] == 1 && k == 0) || (BCs[2] == 1 && k == N[2] - 1))){
+			SrhoE = S->Q[sidx];
+			for(int dim = 0; dim < effD; dim++){
+				Srhov[dim] = rho[sidx]*S->a[effD*sidx + dim];
+				SrhoE += rhov[effD*sidx + dim]*S->a[effD*sidx + dim];
+			}
+		}
 
-							//Step 5: Update Phi at cell center, need new eq and tau
-							//Compute Flow velocity u and temperature T
-							double u = 0; //old flow velocity
-							for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} u = sqrt(u);
-							double T = Temperature(rhoE[sidx]/rho[sidx], u); //old temp
-							//Compute new taus
-							double tg = visc(T)/rho[sidx]/R/T; // tau = mu/P, P = rho*R*T.
-							double tb = tg/Pr; 
+		rho[sidx] += -(dt/V*Fm[MOM_RHO*Nc + sidx]);
+		for(int dim = 0; dim < effD; dim++){
+			rhov[effD*sidx + dim] += -dt/V*Fm[(MOM_XI + dim)*Nc + sidx] + dt*Srhov[dim];
+		}
+		rhoE[sidx] += -dt/V*Fm[(1+effD)*Nc + sidx] + dt*SrhoE;
 
-							//printf("taus are = {%f, %f}\n", tg, tb);
+		if(debug == 1){printf("rho[%d] = %f, rhoE[%d] = %f\n", sidx, rho[sidx], sidx, rhoE[sidx]);}
+	}
 
-							//Compute new eq's
-							c2 = 0; //reset c2 from before
-							for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);} //TODO: Potential BUG, did not double check algebra.
-							double g_eq = geq(c2, rho[sidx], T);
-							double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*To)/2;
+	//Step 5, second half: implicit terms with new eq's and taus
+	for(int i = lo[0]; i < hi[0]; i++){
+		for(int j = lo[1]; j < hi[1]; j++){
+			for(int k = lo[2]; k < hi[2]; k++){
+	
+				int sidx = i + Nx*j + Nx*Ny*k;
 
+				if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) ||
+				   (BCs[1] == 1 && j == 0) || (BCs[1] == 1 && j == N[1] - 1) ||
+				   (BCs[2] == 1 && k == 0) || (BCs[2] == 1 && k == N[2] - 1)){continue;} // Dirichlet: no change
 
-							//Update phi
-							double testold = g[idx];
+				//Compute Flow velocity u and temperature T
+				double u = 0; //new flow velocity
+				for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];} u = sqrt(u);
+				double T = Temperature(rhoE[sidx]/rho[sidx], u); //new temp
+				//Compute new taus
+				double tg = visc(T)/rho[sidx]/R/T; // tau = mu/P, P = rho*R*T.
+				double tb = tg/Pr; 
 
-							if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) ||
-							   (BCs[1] == 1 && j == 0) || (BCs[1] == 1 && j == N[1] - 1) ||
-							   (BCs[2] == 1 && k == 0) || (BCs[2] == 1 && k == N[2] - 1))
-							{
-								g[idx] = g[idx];
-								b[idx] = b[idx];
-							}else{
-								g[idx] = (g[idx] + dt/2*(g_eq/tg + (g_eqo-g[idx])/tgo) - dt/V*Fg[idx] + dt*0)/(1+dt/2/tg); //TODO replace 0 with source term
-								b[idx] = (b[idx] + dt/2*(b_eq/tb + (b_eqo-b[idx])/tbo) - dt/V*Fb[idx] + dt*0)/(1+dt/2/tb); //TODO replace 0 with source term
-							}
+				for(int vx = 0; vx < NV[0]; vx++){
+					for(int vy = 0; vy < NV[1]; vy++){
+						for(int vz = 0; vz < NV[2]; vz++){
+
+							int idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
+							double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+							//Compute new eq's
+							double c2 = 0;
+							for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);}
+							double g_eq = geq(c2, rho[sidx], T);
+							double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+							g[idx] = (g[idx] + dt/2*g_eq/tg)/(1+dt/2/tg);
+							b[idx] = (b[idx] + dt/2*b_eq/tb)/(1+dt/2/tb);
 						}
 					}
 				}
-				if(debug == 1){printf("rho[%d] = %f, rhoE[%d] = %f\n", sidx, rho[sidx], sidx, rhoE[sidx]);}
-				assert(rho[sidx] == rho[sidx]); // NaN checker
 			}
 		}
 	}
@@ -674,4 +763,55 @@ void Step4and5(double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, d
 
 
 
+//Kernel selection
+template <int D, int BCX, int BCY, int BCZ> static void SelectBC(StepKernels* SK){
+
+	if(SK->limiter == LIM_MINMOD){SK->Step1b = Step1bK<D, BCX, BCY, BCZ, LIM_MINMOD>;}
+	else if(SK->limiter == LIM_MC){SK->Step1b = Step1bK<D, BCX, BCY, BCZ, LIM_MC>;}
+	else if(SK->limiter == LIM_SUPERBEE){SK->Step1b = Step1bK<D, BCX, BCY, BCZ, LIM_SUPERBEE>;}
+	else{SK->Step1b = Step1bK<D, BCX, BCY, BCZ, LIM_VANLEER>;}
+	SK->Step1c = Step1cK<D, BCX, BCY, BCZ>;
+	SK->Step2c = Step2cK<D, BCX, BCY, BCZ>;
+	SK->Step4and5 = Step4and5K<D, BCX, BCY, BCZ>;
+}
+
+//Axes beyond D are never read, they are instantiated as periodic only.
+template <int D, int BCX, int BCY> static void SelectBCZ(StepKernels* SK, int bz){
+
+	if constexpr(D < 3){SelectBC<D, BCX, BCY, 0>(SK);}
+	else if(bz == 0){SelectBC<D, BCX, BCY, 0>(SK);}
+	else if(bz == 1){SelectBC<D, BCX, BCY, 1>(SK);}
+	else{SelectBC<D, BCX, BCY, 2>(SK);}
+}
+
+template <int D, int BCX> static void SelectBCY(StepKernels* SK, int by, int bz){
+
+	if constexpr(D < 2){SelectBCZ<D, BCX, 0>(SK, bz);}
+	else if(by == 0){SelectBCZ<D, BCX, 0>(SK, bz);}
+	else if(by == 1){SelectBCZ<D, BCX, 1>(SK, bz);}
+	else{SelectBCZ<D, BCX, 2>(SK, bz);}
+}
+
+template <int D> static void SelectD(StepKernels* SK, int* BCs){
+
+	SK->Step1a = Step1aK<D>;
+	SK->Step2b = Step2bK<D>;
+
+	if(BCs[0] == 0){SelectBCY<D, 0>(SK, BCs[1], BCs[2]);}
+	else if(BCs[0] == 1){SelectBCY<D, 1>(SK, BCs[1], BCs[2]);}
+	else{SelectBCY<D, 2>(SK, BCs[1], BCs[2]);}
+}
+
+void SelectStepKernels(StepKernels* SK, int effD, int* BCs, int limiter, double* rh){
+
+	assert(effD >= 1 && effD <= 3);
+	for(int d = 0; d < effD; d++){assert(BCs[d] >= 0 && BCs[d] <= 2);}
+	assert(limiter >= 0 && limiter < LIM_COUNT);
 
+	SK->limiter = limiter;
+	for(int d = 0; d < 3; d++){SK->rh[d] = rh[d];}
+
+	if(effD == 1){SelectD<1>(SK, BCs);}
+	if(effD == 2){SelectD<2>(SK, BCs);}
+	if(effD == 3){SelectD<3>(SK, BCs);}
+}
@@ -4,6 +4,9 @@
 
 #include "Mesh.hh"
 #include "Functions.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Limiters.hh"
 
 /*
 extern int testProblem;
@@ -20,19 +23,88 @@ extern double K;
 */
 
 
-int Evolve(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, double* Sg, double* Sb, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+// Slab s0 <= s < s1 of the last active axis: the box lo <= (i, j, k) < hi, which is the contiguous range
+// c0 <= sidx < c1 as the axes beyond effD have a single cell. The whole domain is 0 <= s < N[effD-1].
+static inline void Slab(int effD, int s0, int s1, int* N, int* lo, int* hi, int* c0, int* c1){
 
-void Step1a(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, double* Sg, double* Sb, double* rho, double* rhov, double* rhoE, double dt, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
-void Step1b(double* gbarp, double* bbarp, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* Co_X, double* Co_Y, double* Co_Z, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
-void Step1c(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma2, double* bsigma2, double dt, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
+	int plane = 1;
+	for(int d = 0; d < 3; d++){lo[d] = 0; hi[d] = N[d];}
+	for(int d = 0; d < effD - 1; d++){plane *= N[d];}
+	lo[effD-1] = s0;
+	hi[effD-1] = s1;
+	*c0 = s0*plane;
+	*c1 = s1*plane;
+}
 
-void Step2a(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, double* Co_WX, double* Co_WY, double* Co_WZ, double dt, double* rhoh, double* rhovh, double* rhoEh, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
-void Step2b(double* gbar, double* bbar, double dt, double* rhoh, double* rhovh, double* rhoEh, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
-void Step2c(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, Cell* mesh, double* Fg, double* Fb, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
+// A cell's step reads the state of the cells up to STEP_REACH away along each axis (the slopes of the
+// neighbours' interface values), so a slab's step depends on the STEP_REACH rows on either side.
+#define STEP_REACH 3
 
-void Step3();
-void Step4and5(double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, double* Fg, double* Fb, double* Co_X, double* Co_Y, double* Co_Z, double* Co_WX, double* Co_WY, double* Co_WZ, double* g, double* b, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD);
+// Rows (cells of the last active axis) set in in, widened by rad rows on each side, wrapped if periodic.
+static inline void RowsWiden(const char* in, char* out, int rad, int nrow, int periodic){
+
+	for(int r = 0; r < nrow; r++){
+		out[r] = 0;
+		for(int o = -rad; o <= rad; o++){
+			int rr = r + o;
+			if(periodic){rr = ((rr%nrow) + nrow)%nrow;}
+			else if(rr < 0 || rr >= nrow){continue;}
+			out[r] |= in[rr];
+		}
+	}
+}
+
+// Maximal runs s0[n] <= s < s1[n] of the rows set in mask, as slabs for the kernels. Returns their count.
+static inline int RowsRuns(const char* mask, int nrow, int* s0, int* s1){
+
+	int n = 0;
+	for(int r = 0; r < nrow;){
+		if(!mask[r]){r++; continue;}
+		int e = r;
+		while(e < nrow && mask[e]){e++;}
+		s0[n] = r;
+		s1[n] = e;
+		n++;
+		r = e;
+	}
+	return n;
+}
+
+// Steps 1a-1c, 2b, 2c and 4/5 are compiled once per dimensionality and per boundary condition kind on each
+// axis (0 periodic, 1 Dirichlet, 2 Neumann), so the effD and effD x effD loops unroll, the boundary tests
+// fold away and the unused velocity axes of 1D and 2D problems drop out. SelectStepKernels picks the
+// instantiations for a problem once, at startup; Evolve calls them through the table.
+// Every kernel works on the cells of a slab s0 <= s < s1 of the last active axis (see Slab), Evolve passes
+// the whole domain and the tiled step (Tiles.hh) one slab per task. Step 1b runs its passes pass0 <= pass < pass1
+// (0 the slopes at cells, 1 the interface values). Fm (2+effD rows of Nc) and tree (MomentsTreeSize) are the
+// Step 4 moment scratch, the tree one per thread.
+// Step 1b is also compiled once per slope limiter (Limiters.hh). rh is 1/spacing of each axis on a uniform
+// mesh, 0 where the spacing varies, in which case the slopes are taken from the cell centers.
+struct StepKernels{
+
+	void (*Step1a)(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double dt, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int s0, int s1);
+	void (*Step1b)(double* gbarp, double* bbarp, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* rh, double* gbarpbound, double* bbarpbound, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int pass0, int pass1, int s0, int s1);
+	void (*Step1c)(double* gbar, double* bbar, double* gbarpbound, double*bbarpbound, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double* gsigma2, double* bsigma2, double dt, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int s0, int s1);
+
+	void (*Step2b)(double* gbar, double* bbar, Source* S, double dt, double* rhoh, double* rhovh, double* rhoEh, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int s0, int s1);
+	void (*Step2c)(double* gbar, double* bbar, double* Co_X, double* Co_Y, double* Co_Z, Cell* mesh, double* Fg, double* Fb, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int s0, int s1);
+
+	void (*Step4and5)(double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, double* Fg, double* Fb, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, Source* S, double* g, double* b, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int s0, int s1, double* Fm, double* tree);
+
+	int limiter;
+	double rh[3];
+};
+
+// Velocity axes beyond effD must have a single point (NV[d] = 1 for d >= effD).
+void SelectStepKernels(StepKernels* SK, int effD, int* BCs, int limiter, double* rh);
+
+int Evolve(double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+// gm is scratch of (1+effD) rows of Nc*effD, tree as for Step 4.
+void Step2a(double* gbar, double* bbar, MomentBasis* M, Source* S, double dt, double* rhoh, double* rhovh, double* rhoEh, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, int s0, int s1, double* gm, double* tree);
+void Step3(Source* S, double* rho, double* rhov, double* rhoE, int* N, int effD, int s0, int s1);
 
 double TimeStep(double dt, double dtdump, double tend);
+double StableTimeStep(int* N, double* Vmax);
 
 #endif
\ No newline at end of file
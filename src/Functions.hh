@@ -11,7 +11,6 @@ double visc(double T);
 template <typename T> int sgn(T val) {
     return (T(0) < val) - (val < T(0));
 }
-double VanLeer(double L, double C, double R, double xL, double xC, double xR);
 
 
 
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#include "Health.hh"
+
+// Comparisons are false for NaN, so each test also catches NaN.
+static inline int BadW(double rho, const double* rhov, double rhoE, int effD){
+
+	double m2 = 0;
+	for(int d = 0; d < effD; d++){m2 += rhov[d]*rhov[d];}
+	double eint = rhoE - 0.5*m2/rho;
+
+	int ok = (rho > 0) & (rho <= DBL_MAX) & (eint > 0) & (fabs(rhoE) <= DBL_MAX) & (m2 <= DBL_MAX);
+	return !ok;
+}
+
+static inline int BadG(double g, double b, double gmax){
+
+	int ok = (g >= -HEALTH_GTOL*gmax) & (g <= DBL_MAX) & (fabs(b) <= DBL_MAX);
+	return !ok;
+}
+
+static void PrintCell(const char* label, int sidx, double* rho, double* rhov, double* rhoE, int* N, int effD){
+
+	int i = sidx%N[0];
+	int j = (sidx/N[0])%N[1];
+	int k = sidx/(N[0]*N[1]);
+
+	double m2 = 0;
+	for(int d = 0; d < effD; d++){m2 += rhov[effD*sidx + d]*rhov[effD*sidx + d];}
+
+	printf("  %s cell %d (%d, %d, %d): rho = %e, rhov = {", label, sidx, i, j, k, rho[sidx]);
+	for(int d = 0; d < effD; d++){printf(d == 0 ? "%e" : ", %e", rhov[effD*sidx + d]);}
+	printf("}, rhoE = %e, internal energy = %e\n", rhoE[sidx], rhoE[sidx] - 0.5*m2/rho[sidx]);
+}
+
+int HealthCheck(double* g, double* b, double* rho, double* rhov, double* rhoE, int iter, double Tsim, double* Co_X, double* Co_Y, double* Co_Z, int* N, int* NV, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+	int Nv = NV[0]*NV[1]*NV[2];
+
+	int badW = 0;
+	for(int c = 0; c < Nc; c++){badW += BadW(rho[c], rhov + effD*c, rhoE[c], effD);}
+
+	//NaN never compares greater, so it does not reach gmax and is counted by BadG
+	double* gmax = new double[Nc];
+	for(int c = 0; c < Nc; c++){gmax[c] = 0;}
+	for(int v = 0; v < Nv; v++){
+		const double* gv = g + (long)v*Nc;
+		for(int c = 0; c < Nc; c++){gmax[c] = (gv[c] > gmax[c]) ? gv[c] : gmax[c];}
+	}
+
+	long badG = 0;
+	for(int v = 0; v < Nv; v++){
+		const double* gv = g + (long)v*Nc;
+		const double* bv = b + (long)v*Nc;
+		for(int c = 0; c < Nc; c++){badG += BadG(gv[c], bv[c], gmax[c]);}
+	}
+
+	if(badW == 0 && badG == 0){delete[] gmax; return 1;}
+
+	printf("Health check failed at iteration = %d, Tsim = %f: %d bad cells, %ld bad distribution entries\n", iter, Tsim, badW, badG);
+
+	if(badW > 0){
+		int c = 0;
+		while(!BadW(rho[c], rhov + effD*c, rhoE[c], effD)){c++;}
+
+		if(c > 0){PrintCell("left of first bad", c - 1, rho, rhov, rhoE, N, effD);}
+		PrintCell("first bad", c, rho, rhov, rhoE, N, effD);
+		if(c < Nc - 1){PrintCell("right of first bad", c + 1, rho, rhov, rhoE, N, effD);}
+	}
+
+	if(badG > 0){
+		long idx = 0;
+		while(!BadG(g[idx], b[idx], gmax[idx%Nc])){idx++;}
+
+		int sidx = idx%Nc;
+		int v = idx/Nc;
+		int vx = v%NV[0];
+		int vy = (v/NV[0])%NV[1];
+		int vz = v/(NV[0]*NV[1]);
+
+		printf("  first bad g/b at cell %d, velocity %d (%d, %d, %d), Xi = {%e, %e, %e}, largest g of the cell = %e\n", sidx, v, vx, vy, vz, Co_X[vx], Co_Y[vy], Co_Z[vz], gmax[sidx]);
+		PrintCell("its", sidx, rho, rhov, rhoE, N, effD);
+		for(int dv = -2; dv <= 2; dv++){
+			if(vx + dv < 0 || vx + dv >= NV[0]){continue;}
+			long n = idx + (long)dv*Nc;
+			printf("  vx = %d: g = %e, b = %e\n", vx + dv, g[n], b[n]);
+		}
+	}
+
+	delete[] gmax;
+	return 0;
+}
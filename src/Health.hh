@@ -0,0 +1,18 @@
+#ifndef HEALTH_HH
+#define HEALTH_HH
+
+// Solver health monitor, run between timesteps instead of checks inside the kernels.
+// Two passes over g, one for the largest g of each cell and one counting bad entries without branching,
+// so both vectorize and the check costs about as much as reading g twice and b once. Bad entries are
+// NaN/Inf anywhere, rho <= 0, T <= 0 (internal energy rhoE - |rhov|^2/(2 rho) <= 0) and
+// g < -HEALTH_GTOL times the largest g of the cell. The tails of g undershoot zero where the
+// reconstruction crosses steep gradients: up to 2e-5 of the cell peak in the first steps of KHI, about
+// 1e-26 in Sod. Only when the count is nonzero is the state searched again for the first offending cell
+// and velocity, which are reported with their neighbours.
+
+#define HEALTH_GTOL 1e-3 // Negative g tolerated, relative to the largest g of the cell
+
+// Returns 1 if the state is healthy, otherwise prints the report and returns 0.
+int HealthCheck(double* g, double* b, double* rho, double* rhov, double* rhoE, int iter, double Tsim, double* Co_X, double* Co_Y, double* Co_Z, int* N, int* NV, int effD);
+
+#endif
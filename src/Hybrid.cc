@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Hybrid.hh"
+
+
+void HybridInit(Hybrid* H, double kn, int* N, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+	int nq = 2 + effD;
+
+	H->kn = kn;
+	H->nrow = N[effD-1];
+	H->kinetic = new char[H->nrow];
+	H->active = new char[H->nrow];
+	H->valid = new char[H->nrow];
+	H->seed = new char[H->nrow];
+	H->Kn = new double[H->nrow];
+	H->run0 = new int[H->nrow];
+	H->run1 = new int[H->nrow];
+	for(int r = 0; r < H->nrow; r++){
+		H->kinetic[r] = 0;
+		H->valid[r] = 1; // The initial g and b are set from the initial conditions everywhere
+	}
+	H->nkinetic = 0;
+
+	H->P = new double[nq*Nc];
+	H->G = new double[nq*effD*Nc];
+	H->Sl = new double[nq*effD*Nc];
+	H->Ph = new double[nq*Nc];
+	H->Fw = new double[nq*effD*Nc];
+}
+
+void HybridFree(Hybrid* H){
+
+	delete[] H->kinetic;
+	delete[] H->active;
+	delete[] H->valid;
+	delete[] H->seed;
+	delete[] H->Kn;
+	delete[] H->run0;
+	delete[] H->run1;
+	delete[] H->P;
+	delete[] H->G;
+	delete[] H->Sl;
+	delete[] H->Ph;
+	delete[] H->Fw;
+}
+
+
+// Cell index one step from i along an axis of n cells: wrapped if periodic, else clamped.
+static inline int Neighbour(int i, int step, int n, int BC){
+
+	int j = i + step;
+	if(BC == 0){return (j + n)%n;}
+	return j < 0 ? 0 : (j >= n ? n - 1 : j);
+}
+
+// Primitives, their centered and limited gradients and the half step predictions in every cell, and the
+// largest Knudsen number of each row.
+static void HybridState(Hybrid* H, double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, int* BCs, int limiter, double R, double gma, int* N, int effD){
+
+	int Nx = N[0];
+	int Ny = N[1];
+	int Nc = N[0]*N[1]*N[2];
+	int nq = 2 + effD;
+	double* P = H->P;
+
+	for(int sidx = 0; sidx < Nc; sidx++){
+		double u = 0;
+		P[nq*sidx] = rho[sidx];
+		for(int d = 0; d < effD; d++){
+			P[nq*sidx + 1 + d] = rhov[effD*sidx + d]/rho[sidx];
+			u += P[nq*sidx + 1 + d]*P[nq*sidx + 1 + d];
+		}
+		P[nq*sidx + 1 + effD] = Temperature(rhoE[sidx]/rho[sidx], sqrt(u));
+	}
+
+	for(int r = 0; r < H->nrow; r++){H->Kn[r] = 0;}
+
+	for(int i = 0; i < N[0]; i++){
+		for(int j = 0; j < N[1]; j++){
+			for(int k = 0; k < N[2]; k++){
+
+				int sidx = i + Nx*j + Nx*Ny*k;
+				int pos[3] = {i, j, k};
+				double h[3] = {mesh[sidx].dx, mesh[sidx].dy, mesh[sidx].dz};
+				double* p = P + nq*sidx;
+
+				for(int d = 0; d < effD; d++){
+					int posL[3] = {i, j, k};
+					int posR[3] = {i, j, k};
+					posL[d] = Neighbour(pos[d], -1, N[d], BCs[d]);
+					posR[d] = Neighbour(pos[d], 1, N[d], BCs[d]);
+					int sL = posL[0] + Nx*posL[1] + Nx*Ny*posL[2];
+					int sR = posR[0] + Nx*posR[1] + Nx*Ny*posR[2];
+					double span = BCs[d] == 0 ? 2 : (posR[d] != pos[d]) + (posL[d] != pos[d]); // Cells between the neighbours
+
+					for(int q = 0; q < nq; q++){
+						double a = p[q] - P[nq*sL + q];
+						double c = P[nq*sR + q] - p[q];
+						H->G[(nq*sidx + q)*effD + d] = span > 0 ? (a + c)/(span*h[d]) : 0;
+						H->Sl[(nq*sidx + q)*effD + d] = LimitSelect(limiter, a, c)/h[d];
+					}
+				}
+
+				// Local Knudsen number
+				double T = p[1+effD];
+				double RT = R*T;
+				double lambda = visc(T)/(p[0]*RT)*sqrt(RT);
+				double kn = 0;
+				for(int d = 0; d < effD; d++){
+					double* gq = H->G + nq*sidx*effD;
+					kn = fmax(kn, fabs(gq[d])/p[0]);
+					kn = fmax(kn, fabs(gq[(1+effD)*effD + d])/T);
+					for(int e = 0; e < effD; e++){kn = fmax(kn, fabs(gq[(1+e)*effD + d])/sqrt(RT));}
+				}
+				kn *= lambda;
+				int row = pos[effD-1];
+				if(kn > H->Kn[row]){H->Kn[row] = kn;}
+
+				// MUSCL-Hancock: primitives advanced dt/2 by the Euler equations with the limited slopes
+				double* s = H->Sl + nq*sidx*effD;
+				double* ph = H->Ph + nq*sidx;
+				double div = 0;
+				for(int d = 0; d < effD; d++){div += s[(1+d)*effD + d];}
+				double adv[5] = {0, 0, 0, 0, 0}; // u.grad of each primitive
+				for(int q = 0; q < nq; q++){
+					for(int d = 0; d < effD; d++){adv[q] += p[1+d]*s[q*effD + d];}
+				}
+				ph[0] = p[0] - dt/2*(adv[0] + p[0]*div);
+				for(int d = 0; d < effD; d++){
+					ph[1+d] = p[1+d] - dt/2*(adv[1+d] + R*(T*s[d] + p[0]*s[(1+effD)*effD + d])/p[0]);
+				}
+				ph[1+effD] = T - dt/2*(adv[1+effD] + (gma - 1)*T*div);
+				if(ph[0] <= 0 || ph[1+effD] <= 0){
+					for(int q = 0; q < nq; q++){ph[q] = p[q];}
+				}
+			}
+		}
+	}
+}
+
+// Kinetic and active rows of this step.
+static void HybridRows(Hybrid* H, int* BCs, int effD){
+
+	int periodic = (BCs[effD-1] == 0);
+
+	H->nkinetic = 0;
+	for(int r = 0; r < H->nrow; r++){
+		H->seed[r] = (H->Kn[r] >= H->kn) || (H->kinetic[r] && H->Kn[r] >= 0.5*H->kn);
+	}
+	RowsWiden(H->seed, H->kinetic, HYB_BUFFER, H->nrow, periodic);
+	RowsWiden(H->kinetic, H->active, HYB_REACH, H->nrow, periodic);
+	for(int r = 0; r < H->nrow; r++){H->nkinetic += H->kinetic[r];}
+}
+
+// g and b of the active rows that were not evolved the step before, from the first order Chapman-Enskog
+// expansion of the BGK equations about the local equilibrium, with the time derivatives from the Euler equations:
+//   g = g_eq*(1 - tg*Phi),  Phi = D ln g_eq = c.grad(u).c/RT - div(u)*(1 - d/n + c^2/(n RT)) + c.grad(T)/T*(c^2/(2RT) - (d+2)/2),
+//   b = b_eq - tb*g_eq*(e*Phi + (n-d)*RT/2*(c.grad(T)/T - 2/n*div(u))),  e = (Xi^2 + (n-d)RT)/2,
+// with n = 3+K degrees of freedom and d = effD. The force term cancels the acceleration in D u, so gravity does not enter.
+static void HybridReconstruct(Hybrid* H, double* g, double* b, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double Pr, int* N, int* NV, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+	int nq = 2 + effD;
+	int plane = Nc/H->nrow;
+	double n = 3 + K;
+
+	for(int r = 0; r < H->nrow; r++){
+		if(!H->active[r] || H->valid[r]){continue;}
+
+		for(int sidx = r*plane; sidx < (r+1)*plane; sidx++){
+
+			double* p = H->P + nq*sidx;
+			double* gq = H->G + nq*sidx*effD;
+			double T = p[1+effD];
+			double RT = R*T;
+			double tg = visc(T)/p[0]/RT; // tau = mu/P, P = rho*R*T.
+			double tb = tg/Pr;
+			double div = 0;
+			for(int d = 0; d < effD; d++){div += gq[(1+d)*effD + d];}
+
+			for(int vx = 0; vx < NV[0]; vx++){
+				for(int vy = 0; vy < NV[1]; vy++){
+					for(int vz = 0; vz < NV[2]; vz++){
+
+						int idx = sidx + Nc*vx + Nc*NV[0]*vy + Nc*NV[0]*NV[1]*vz;
+						double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+						double c[3];
+						double c2 = 0;
+						double cT = 0; // c.grad(T)/T
+						for(int d = 0; d < effD; d++){
+							c[d] = Xi[d] - p[1+d];
+							c2 += c[d]*c[d];
+							cT += c[d]*gq[(1+effD)*effD + d]/T;
+						}
+						double cuc = 0; // c.grad(u).c
+						for(int d = 0; d < effD; d++){
+							for(int e = 0; e < effD; e++){cuc += c[e]*c[d]*gq[(1+e)*effD + d];}
+						}
+
+						double Phi = cuc/RT - div*(1 - effD/n + c2/(n*RT)) + cT*(c2/(2*RT) - (effD + 2)/2.);
+						double g_eq = geq(c2, p[0], T);
+						double e = (Xi[0]*Xi[0] + Xi[1]*Xi[1] + Xi[2]*Xi[2] + (3-effD+K)*RT)/2;
+
+						g[idx] = g_eq*(1 - tg*Phi);
+						b[idx] = g_eq*(e - tb*(e*Phi + (3-effD+K)*RT/2*(cT - 2/n*div)));
+					}
+				}
+			}
+		}
+	}
+}
+
+// Flux of the part of the Maxwellian (rho, u, T) moving along +d (sgn 1) or -d (sgn -1), added to F.
+static void HalfFlux(double rho, double* u, double T, int d, int sgn, double R, double n, int effD, double* F){
+
+	double PI = 4.0*atan(1.0);
+	double RT = R*T;
+	double un = u[d];
+	double s = un/sqrt(2*RT);
+	double A = 0.5*erfc(-sgn*s);                    // Share of the particles
+	double B = sgn*sqrt(RT/(2*PI))*exp(-s*s);
+	double M1 = rho*(un*A + B);                      // Half range moments of Xi_d
+	double M2 = rho*((un*un + RT)*A + un*B);
+	double M3 = rho*((un*un*un + 3*un*RT)*A + (un*un + 2*RT)*B);
+
+	double ut2 = 0;
+	for(int e = 0; e < effD; e++){
+		if(e == d){F[1+e] += M2;}
+		else{F[1+e] += u[e]*M1; ut2 += u[e]*u[e];}
+	}
+	F[0] += M1;
+	F[1+effD] += 0.5*M3 + 0.5*(ut2 + (n - 1)*RT)*M1;
+}
+
+// Face fluxes for the continuum update: the right face of each cell along each axis, where a continuum row is on
+// either side. Faces next to a kinetic row take the moments of the interface distribution, the others the
+// Navier-Stokes flux.
+static void HybridFluxes(Hybrid* H, double* gbar, double* bbar, MomentBasis* M, Cell* mesh, int* BCs, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, double gma, double Pr, int* N, int* NV, int effD){
+
+	int Nx = N[0];
+	int Ny = N[1];
+	int Nc = N[0]*N[1]*N[2];
+	int Nv = NV[0]*NV[1]*NV[2];
+	int nq = 2 + effD;
+	double n = 3 + K;
+	double kappa_mu = gma/(gma - 1)*R/Pr; // Cp/Pr
+
+	for(int i = 0; i < N[0]; i++){
+		for(int j = 0; j < N[1]; j++){
+			for(int k = 0; k < N[2]; k++){
+
+				int sidx = i + Nx*j + Nx*Ny*k;
+				int pos[3] = {i, j, k};
+				int row = pos[effD-1];
+				double h[3] = {mesh[sidx].dx, mesh[sidx].dy, mesh[sidx].dz};
+
+				for(int d = 0; d < effD; d++){
+
+					double* F = H->Fw + nq*(effD*sidx + d);
+					for(int q = 0; q < nq; q++){F[q] = 0;}
+					if(BCs[d] != 0 && pos[d] == N[d] - 1){continue;} // Wall, no flux
+
+					int posR[3] = {i, j, k};
+					posR[d] = Neighbour(pos[d], 1, N[d], BCs[d]);
+					int sR = posR[0] + Nx*posR[1] + Nx*Ny*posR[2];
+					int rowR = posR[effD-1];
+
+					if(H->kinetic[row] && H->kinetic[rowR]){continue;} // Not read
+
+					if(H->kinetic[row] || H->kinetic[rowR]){
+						// Moments of Xi_d times the original distribution at the interface, as in Step 2c
+						for(int v = 0; v < Nv; v++){
+							int vx = v%NV[0], vy = (v/NV[0])%NV[1], vz = v/(NV[0]*NV[1]);
+							double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+							double wg = M->B[MOM_RHO*Nv + v]*Xi[d]*gbar[effD*(sidx + Nc*v) + d];
+							F[0] += wg;
+							for(int e = 0; e < effD; e++){F[1+e] += Xi[e]*wg;}
+							F[1+effD] += M->B[MOM_RHO*Nv + v]*Xi[d]*bbar[effD*(sidx + Nc*v) + d];
+						}
+						continue;
+					}
+
+					// Inviscid part: half Maxwellian fluxes of the MUSCL-Hancock face states
+					double qL[5], qR[5];
+					for(int q = 0; q < nq; q++){
+						qL[q] = H->Ph[nq*sidx + q] + h[d]/2*H->Sl[(nq*sidx + q)*effD + d];
+						qR[q] = H->Ph[nq*sR + q] - h[d]/2*H->Sl[(nq*sR + q)*effD + d];
+					}
+					if(qL[0] <= 0 || qL[1+effD] <= 0){for(int q = 0; q < nq; q++){qL[q] = H->Ph[nq*sidx + q];}}
+					if(qR[0] <= 0 || qR[1+effD] <= 0){for(int q = 0; q < nq; q++){qR[q] = H->Ph[nq*sR + q];}}
+					HalfFlux(qL[0], qL + 1, qL[1+effD], d, 1, R, n, effD, F);
+					HalfFlux(qR[0], qR + 1, qR[1+effD], d, -1, R, n, effD, F);
+
+					// Viscous part: normal derivatives across the face, tangential ones averaged from the two cells
+					double* pL = H->P + nq*sidx;
+					double* pR = H->P + nq*sR;
+					double T = 0.5*(pL[1+effD] + pR[1+effD]);
+					double u[3];
+					double du[3][3]; // du[e][f] = d u_e/d x_f
+					double dT[3];
+					for(int f = 0; f < effD; f++){
+						for(int e = 0; e < effD; e++){
+							du[e][f] = f == d ? (pR[1+e] - pL[1+e])/h[d] : 0.5*(H->G[(nq*sidx + 1 + e)*effD + f] + H->G[(nq*sR + 1 + e)*effD + f]);
+						}
+						dT[f] = f == d ? (pR[1+effD] - pL[1+effD])/h[d] : 0.5*(H->G[(nq*sidx + 1 + effD)*effD + f] + H->G[(nq*sR + 1 + effD)*effD + f]);
+						u[f] = 0.5*(pL[1+f] + pR[1+f]);
+					}
+					double mu = visc(T);
+					double div = 0;
+					for(int e = 0; e < effD; e++){div += du[e][e];}
+					for(int e = 0; e < effD; e++){
+						double sigma = mu*(du[d][e] + du[e][d] - (e == d)*2/n*div);
+						F[1+e] -= sigma;
+						F[1+effD] -= sigma*u[e];
+					}
+					F[1+effD] -= kappa_mu*mu*dT[d];
+				}
+			}
+		}
+	}
+}
+
+// Finite volume update of the continuum rows, with the sources of Step 4.
+static void HybridUpdate(Hybrid* H, double* rho, double* rhov, double* rhoE, double dt, Cell* mesh, Source* S, int* BCs, int* N, int effD){
+
+	int Nx = N[0];
+	int Ny = N[1];
+	int nq = 2 + effD;
+
+	for(int i = 0; i < N[0]; i++){
+		for(int j = 0; j < N[1]; j++){
+			for(int k = 0; k < N[2]; k++){
+
+				int sidx = i + Nx*j + Nx*Ny*k;
+				int pos[3] = {i, j, k};
+				if(H->kinetic[pos[effD-1]]){continue;}
+
+				if((BCs[0] == 1 && i == 0) || (BCs[0] == 1 && i == N[0] - 1) ||
+				   (BCs[1] == 1 && j == 0) || (BCs[1] == 1 && j == N[1] - 1) ||
+				   (BCs[2] == 1 && k == 0) || (BCs[2] == 1 && k == N[2] - 1)){continue;} // Dirichlet: no change
+
+				double V = mesh[sidx].dx*mesh[sidx].dy*mesh[sidx].dz;
+				double A[3] = {mesh[sidx].dy*mesh[sidx].dz, mesh[sidx].dx*mesh[sidx].dz, mesh[sidx].dx*mesh[sidx].dy};
+				double dW[5] = {0, 0, 0, 0, 0};
+
+				for(int d = 0; d < effD; d++){
+					int posL[3] = {i, j, k};
+					posL[d] = Neighbour(pos[d], -1, N[d], BCs[d]);
+					int sL = posL[0] + Nx*posL[1] + Nx*Ny*posL[2];
+					double left = (BCs[d] != 0 && pos[d] == 0) ? 0. : 1.;
+					for(int q = 0; q < nq; q++){
+						dW[q] += A[d]*(H->Fw[nq*(effD*sidx + d) + q] - left*H->Fw[nq*(effD*sL + d) + q]);
+					}
+				}
+
+				double Srhov[3] = {0, 0, 0};
+				double SrhoE = 0;
+				if(S->on){
+					SrhoE = S->Q[sidx];
+					for(int dim = 0; dim < effD; dim++){
+						Srhov[dim] = rho[sidx]*S->a[effD*sidx + dim];
+						SrhoE += rhov[effD*sidx + dim]*S->a[effD*sidx + dim];
+					}
+				}
+
+				rho[sidx] += -dt/V*dW[0];
+				for(int dim = 0; dim < effD; dim++){
+					rhov[effD*sidx + dim] += -dt/V*dW[1+dim] + dt*Srhov[dim];
+				}
+				rhoE[sidx] += -dt/V*dW[1+effD] + dt*SrhoE;
+			}
+		}
+	}
+}
+
+
+int EvolveHybrid(Hybrid* H, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
+
+	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
+
+	int dump = (*dt < calcdt);
+
+	int Nc = N[0]*N[1]*N[2];
+	double* work = MomentsWork(M, (1+effD)*Nc*effD + (2+effD)*Nc); // Step 2a moments, then Step 4's
+	double* Fm = work + (1+effD)*Nc*effD;
+
+	Step3(S, rho, rhov, rhoE, N, effD, 0, N[effD-1]); //Sources from W at the start of the step
+
+	//Split the rows, and rebuild the distributions the kinetic rows will read
+	HybridState(H, rho, rhov, rhoE, *dt, mesh, BCs, SK->limiter, R, gma, N, effD);
+	HybridRows(H, BCs, effD);
+	HybridReconstruct(H, g, b, Co_X, Co_Y, Co_Z, R, K, Pr, N, NV, effD);
+
+	//Steps 1a to 2c on each run of active rows, as Evolve does on the whole domain
+	int nrun = RowsRuns(H->active, H->nrow, H->run0, H->run1);
+	for(int r = 0; r < nrun; r++){
+		int s0 = H->run0[r];
+		int s1 = H->run1[r];
+		SK->Step1a(g, b, gbar, bbar, gbarp, bbarp, S, rho, rhov, rhoE, *dt, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, 1, H->run0[r], H->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 1, 2, H->run0[r], H->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step1c(gbar, bbar, gbarpbound, bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma2, bsigma2, *dt, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, H->run0[r], H->run1[r]);
+	}
+	for(int r = 0; r < nrun; r++){
+		int s0 = H->run0[r];
+		int s1 = H->run1[r];
+		Step2a(gbar, bbar, M, S, *dt, rhoh, rhovh, rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, s0, s1, work, M->tree);
+		SK->Step2b(gbar, bbar, S, *dt, rhoh, rhovh, rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+	}
+	for(int r = 0; r < nrun; r++){
+		SK->Step2c(gbar, bbar, Co_X, Co_Y, Co_Z, mesh, gbarp, bbarp, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, H->run0[r], H->run1[r]);
+	}
+
+	//Continuum fluxes from W at the start of the step, before the kinetic rows update theirs
+	HybridFluxes(H, gbar, bbar, M, mesh, BCs, Co_X, Co_Y, Co_Z, R, K, gma, Pr, N, NV, effD);
+
+	nrun = RowsRuns(H->kinetic, H->nrow, H->run0, H->run1);
+	for(int r = 0; r < nrun; r++){
+		SK->Step4and5(rho, rhov, rhoE, *dt, mesh, gbarp, bbarp, Co_X, Co_Y, Co_Z, M, S, g, b, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, H->run0[r], H->run1[r], Fm, M->tree);
+	}
+	HybridUpdate(H, rho, rhov, rhoE, *dt, mesh, S, BCs, N, effD);
+
+	for(int r = 0; r < H->nrow; r++){H->valid[r] = H->kinetic[r];}
+
+	return dump;
+}
@@ -0,0 +1,59 @@
+#ifndef HYBRID_HH
+#define HYBRID_HH
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Evolution.hh"
+
+// Hybrid continuum/kinetic evolution (-y Kn). The domain is decomposed into the slabs of one cell along
+// the last active axis (rows; cells in 1D), each either kinetic or continuum for a timestep:
+//  - Every step the local Knudsen number of each cell is estimated from its gradient lengths,
+//      Kn = tau*sqrt(RT)*max_d(|d rho|/rho, |d T|/T, |d u|/sqrt(RT)),  tau = mu/p,
+//    by centered differences. A row is kinetic if its largest Kn is at least the threshold, or it was kinetic
+//    and is still above half of it, and the kinetic rows are widened by HYB_BUFFER rows on each side.
+//  - Kinetic rows take the DUGKS step (Steps 1a to 4/5, the same kernels as Evolve). Its stencils reach
+//    HYB_REACH rows, so Steps 1a to 2c run on the kinetic rows widened by HYB_REACH (the active rows), whose
+//    g and b are rebuilt from W as a Chapman-Enskog expansion where they were not evolved the step before.
+//    This is also how a continuum row gets its distribution back when it turns kinetic.
+//  - Continuum rows evolve rho, rhov, rhoE only, with a finite volume update from face fluxes: a kinetic
+//    flux vector splitting of the Navier-Stokes equations (half Maxwellian fluxes of limited, MUSCL-Hancock
+//    face states) plus the viscous stress and heat flux, mu = visc(T), kappa = Cp*mu/Pr, from differences.
+//  - A face with a kinetic row on either side takes the moments of the original distribution at the interface
+//    (after Step 2b), which are the flux Step 2c gives the kinetic cell, so both sides see the same flux and
+//    mass, momentum and energy are conserved to roundoff across the kinetic/continuum boundary.
+// With every row kinetic the step is Evolve, bit for bit. Continuum rows keep their last g and b, which are not
+// read until the rows are rebuilt.
+
+#define HYB_BUFFER 1 // Rows added to each side of the rows over the threshold
+#define HYB_REACH  STEP_REACH // Rows of valid distributions the step of a kinetic row reads on each side
+
+struct Hybrid{
+
+	double kn;       // Knudsen number threshold
+	int nrow;        // Rows, N[effD-1]
+	char* kinetic;   // Rows taking the DUGKS step
+	char* active;    // Rows running Steps 1a to 2c
+	char* valid;     // Rows whose g and b were evolved by the step before
+	char* seed;      // Scratch
+	double* Kn;      // Largest Kn of each row
+	int* run0;       // Runs of kinetic or active rows, run0[r] <= s < run1[r]
+	int* run1;
+	int nkinetic;    // Kinetic rows of the last step
+
+	// Per cell, in cell order: primitives rho, u[effD], T; their centered and limited gradients (times 1/length)
+	// and the primitives predicted to the half step
+	double* P;       // P[(2+effD)*sidx + q]
+	double* G;       // G[((2+effD)*sidx + q)*effD + d]
+	double* Sl;      // As G
+	double* Ph;      // As P
+	double* Fw;      // Flux of rho, rhov, rhoE per unit area through the right face of each cell, Fw[(2+effD)*(effD*sidx + d) + q]
+};
+
+void HybridInit(Hybrid* H, double kn, int* N, int effD);
+void HybridFree(Hybrid* H);
+
+// Same contract as Evolve.
+int EvolveHybrid(Hybrid* H, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef ICFORMAT_HH
+#define ICFORMAT_HH
+
+// Binary initial condition file, shared by the C++ and Regent versions (plain C so Terra can include it).
+// Little-endian, a fixed IC_HEADER_BYTES header followed by the fields as doubles, spatial index
+// sidx = i + N[0]*j + N[0]*N[1]*k:
+//   rho[Nc], rhov[3*Nc] (rhov[3*sidx + d], components beyond effD are ignored), rhoE[Nc],
+// and for IC_PHASE files the full state after that,
+//   g[Nv*Nc], b[Nv*Nc] (g[sidx + Nc*v], v = vx + NV[0]*vy + NV[0]*NV[1]*vz).
+// IC_W files get equilibrium distributions built from W. src/writeic.py writes both kinds.
+// Either kind may end with a static gravitational potential phi[Nc] (potential = 1). The C++ version
+// turns it into an acceleration source; the Regent version has no source terms and ignores it.
+
+#include <stdint.h>
+
+#define IC_MAGIC "CDUGKSIC"
+#define IC_VERSION 1
+#define IC_HEADER_BYTES 512
+
+#define IC_W     0 // Conserved variables only
+#define IC_PHASE 1 // Conserved variables and g, b
+
+struct ICHeader{
+
+	char magic[8];     // IC_MAGIC, not terminated
+	int32_t version;   // IC_VERSION the file was written with
+	int32_t kind;      // IC_W or IC_PHASE
+
+	int32_t effD;
+	int32_t N[3];
+	int32_t NV[3];
+	int32_t BCs[6];    // Low then high side of each axis: 0 periodic, 1 Dirichlet, 2 outflow
+
+	double Vmin[3];
+	double Vmax[3];
+
+	// Gas and viscosity, as in the test problems
+	double R;
+	double K;
+	double Cv;
+	double gma;
+	double w;
+	double ur;
+	double Tr;
+	double Pr;
+
+	double Tf;         // End time, 0 to use the solver default
+	double dtdump;     // Time between dumps, 0 to use the solver default
+
+	int32_t potential; // 1 if phi[Nc] follows the other fields
+};
+
+#endif
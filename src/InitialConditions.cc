@@ -0,0 +1,181 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "Functions.hh"
+#include "InitialConditions.hh"
+
+
+int ICOpen(ICFile* F, const char* path){
+
+	F->map = NULL;
+	F->fd = open(path, O_RDONLY);
+	if(F->fd < 0){printf("Could not open initial conditions %s\n", path); return 0;}
+
+	struct stat st;
+	fstat(F->fd, &st);
+	F->size = st.st_size;
+	if(F->size < IC_HEADER_BYTES){printf("%s is too short for an initial condition header\n", path); ICClose(F); return 0;}
+
+	F->map = mmap(NULL, F->size, PROT_READ, MAP_PRIVATE, F->fd, 0);
+	if(F->map == MAP_FAILED){printf("Could not map initial conditions %s\n", path); F->map = NULL; ICClose(F); return 0;}
+
+	const ICHeader* h = (const ICHeader*)F->map;
+	F->h = h;
+	if(memcmp(h->magic, IC_MAGIC, 8) != 0){printf("%s is not an initial condition file\n", path); ICClose(F); return 0;}
+	if(h->version != IC_VERSION){printf("%s has version %d, this build reads version %d\n", path, h->version, IC_VERSION); ICClose(F); return 0;}
+	if(h->kind != IC_W && h->kind != IC_PHASE){printf("%s has unknown kind %d\n", path, h->kind); ICClose(F); return 0;}
+
+	size_t Nc = (size_t)h->N[0]*h->N[1]*h->N[2];
+	size_t Nv = (size_t)h->NV[0]*h->NV[1]*h->NV[2];
+	size_t need = IC_HEADER_BYTES + 5*Nc*sizeof(double);
+	if(h->kind == IC_PHASE){need += 2*Nc*Nv*sizeof(double);}
+	if(h->potential){need += Nc*sizeof(double);}
+	if(F->size < need){printf("%s holds %zu bytes, its header needs %zu\n", path, F->size, need); ICClose(F); return 0;}
+
+	const double* data = (const double*)((const char*)F->map + IC_HEADER_BYTES);
+	F->rho = data;
+	F->rhov = data + Nc;
+	F->rhoE = data + 4*Nc;
+	F->g = (h->kind == IC_PHASE) ? data + 5*Nc : NULL;
+	F->b = (h->kind == IC_PHASE) ? data + 5*Nc + Nc*Nv : NULL;
+	F->phi = h->potential ? data + 5*Nc + ((h->kind == IC_PHASE) ? 2*Nc*Nv : 0) : NULL;
+
+	printf("Initial conditions %s: %s, N = {%d, %d, %d}, NV = {%d, %d, %d}, effD = %d\n", path, h->kind == IC_PHASE ? "phase space" : "conserved variables", h->N[0], h->N[1], h->N[2], h->NV[0], h->NV[1], h->NV[2], h->effD);
+	if(F->phi != NULL){printf("  with a gravitational potential\n");}
+	return 1;
+}
+
+void ICClose(ICFile* F){
+
+	if(F->map != NULL){munmap(F->map, F->size);}
+	if(F->fd >= 0){close(F->fd);}
+	F->map = NULL;
+	F->fd = -1;
+}
+
+void ICParameters(const ICFile* F, int* N, int* NV, int* Nc, int* Nv, int* BCs, double* Vmin, double* Vmax, double* R, double* K, double* Cv, double* gma, double* w, double* ur, double* Tr, double* Pr, int* effD, double* Tf, double* dtdump){
+
+	const ICHeader* h = F->h;
+
+	*effD = h->effD;
+	for(int d = 0; d < 3; d++){
+		N[d] = h->N[d];
+		NV[d] = h->NV[d];
+		BCs[d] = h->BCs[d]; // The C++ version takes one condition per axis
+		Vmin[d] = h->Vmin[d];
+		Vmax[d] = h->Vmax[d];
+	}
+	*Nc = N[0]*N[1]*N[2];
+	*Nv = NV[0]*NV[1]*NV[2];
+
+	*R = h->R;
+	*K = h->K;
+	*Cv = h->Cv;
+	*gma = h->gma;
+	*w = h->w;
+	*ur = h->ur;
+	*Tr = h->Tr;
+	*Pr = h->Pr;
+
+	if(h->Tf > 0){*Tf = h->Tf;}
+	if(h->dtdump > 0){*dtdump = h->dtdump;}
+}
+
+static int Threads(int nthreads){
+
+	if(nthreads <= 0){nthreads = std::thread::hardware_concurrency();}
+	return nthreads > 0 ? nthreads : 1;
+}
+
+//Cells [c0, c1), velocity-major so each thread writes contiguous runs of g and b.
+static void EquilibriumRange(double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD, int c0, int c1){
+
+	int Nc = N[0]*N[1]*N[2];
+	double* T = new double[c1 - c0];
+
+	for(int sidx = c0; sidx < c1; sidx++){
+		double u = 0;
+		for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];}
+		u = sqrt(u);
+
+		T[sidx - c0] = Temperature(rhoE[sidx]/rho[sidx], u);
+	}
+
+	for(int vx = 0; vx < NV[0]; vx++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vz = 0; vz < NV[2]; vz++){
+
+				long v = vx + NV[0]*vy + NV[0]*NV[1]*vz;
+				double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+				for(int sidx = c0; sidx < c1; sidx++){
+					long idx = sidx + Nc*v;
+					double Ts = T[sidx - c0];
+
+					double c2 = 0;
+					for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);}
+					g[idx] = geq(c2, rho[sidx], Ts);
+					b[idx] = g[idx]*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*Ts)/2;
+				}
+			}
+		}
+	}
+
+	delete[] T;
+}
+
+void InitializeEquilibrium(double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD, int nthreads){
+
+	int Nc = N[0]*N[1]*N[2];
+	nthreads = Threads(nthreads);
+	if(nthreads > Nc){nthreads = Nc;}
+
+	std::vector<std::thread> pool;
+	for(int t = 0; t < nthreads; t++){
+		int c0 = (long)Nc*t/nthreads;
+		int c1 = (long)Nc*(t + 1)/nthreads;
+		pool.push_back(std::thread(EquilibriumRange, g, b, rho, rhov, rhoE, Co_X, Co_Y, Co_Z, R, K, N, NV, effD, c0, c1));
+	}
+	for(int t = 0; t < nthreads; t++){pool[t].join();}
+}
+
+static void CopyRange(double* dst, const double* src, size_t i0, size_t i1){
+	memcpy(dst + i0, src + i0, (i1 - i0)*sizeof(double));
+}
+
+void ICLoad(const ICFile* F, double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD, int nthreads){
+
+	int Nc = N[0]*N[1]*N[2];
+	size_t Ng = (size_t)Nc*NV[0]*NV[1]*NV[2];
+
+	memcpy(rho, F->rho, Nc*sizeof(double));
+	memcpy(rhoE, F->rhoE, Nc*sizeof(double));
+	for(int sidx = 0; sidx < Nc; sidx++){
+		for(int dim = 0; dim < effD; dim++){rhov[effD*sidx + dim] = F->rhov[3*sidx + dim];}
+	}
+
+	if(F->h->kind == IC_W){
+		InitializeEquilibrium(g, b, rho, rhov, rhoE, Co_X, Co_Y, Co_Z, R, K, N, NV, effD, nthreads);
+		return;
+	}
+
+	//Phase space state: copy in parallel, which also spreads the page faults of the map over the threads
+	nthreads = Threads(nthreads);
+	std::vector<std::thread> pool;
+	for(int t = 0; t < nthreads; t++){
+		size_t i0 = Ng*t/nthreads;
+		size_t i1 = Ng*(t + 1)/nthreads;
+		pool.push_back(std::thread(CopyRange, g, F->g, i0, i1));
+		pool.push_back(std::thread(CopyRange, b, F->b, i0, i1));
+	}
+	for(size_t t = 0; t < pool.size(); t++){pool[t].join();}
+}
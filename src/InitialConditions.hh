@@ -0,0 +1,39 @@
+#ifndef INITIALCONDITIONS_HH
+#define INITIALCONDITIONS_HH
+
+#include <stddef.h>
+
+#include "ICFormat.hh"
+
+// External initial conditions. The file is memory mapped, so opening it costs nothing until the
+// fields are read, and they are copied straight from the map into the solver arrays.
+
+struct ICFile{
+
+	int fd;
+	size_t size;
+	void* map;
+
+	const ICHeader* h;
+	const double* rho;
+	const double* rhov;  // Three components per cell
+	const double* rhoE;
+	const double* g;     // NULL unless kind == IC_PHASE
+	const double* b;
+	const double* phi;   // NULL unless the header sets potential
+};
+
+// Map and validate the file (magic, version, kind and size). Returns 1 on success, otherwise prints why and returns 0.
+int ICOpen(ICFile* F, const char* path);
+void ICClose(ICFile* F);
+
+// Problem parameters from the header, in place of TestProblem. Tf and dtdump are left alone when the file has 0.
+void ICParameters(const ICFile* F, int* N, int* NV, int* Nc, int* Nv, int* BCs, double* Vmin, double* Vmax, double* R, double* K, double* Cv, double* gma, double* w, double* ur, double* Tr, double* Pr, int* effD, double* Tf, double* dtdump);
+
+// Fill W, and g and b (copied for IC_PHASE files, equilibrium otherwise).
+void ICLoad(const ICFile* F, double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD, int nthreads);
+
+// g and b set to the local equilibrium of W, built by nthreads threads over contiguous ranges of cells.
+void InitializeEquilibrium(double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_Y, double* Co_Z, double R, double K, int* N, int* NV, int effD, int nthreads);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef LIMITERS_HH
+#define LIMITERS_HH
+
+#include <math.h>
+
+// Slope limiters (-k), selected once per run. Each takes the one-sided slopes a (left) and b (right)
+// and returns zero unless they have the same sign. They are written with selects instead of branches
+// (min/max as ternaries, which compile to minsd/maxsd, and copysign), so loops over cells stay
+// branch-free and can vectorize. Van Leer is the harmonic mean form of the old VanLeer,
+// (a|b| + |a|b)/(|a| + |b|), which is bitwise the same value for the same a and b.
+#define LIM_VANLEER  0
+#define LIM_MINMOD   1
+#define LIM_MC       2
+#define LIM_SUPERBEE 3
+#define LIM_COUNT    4
+
+static inline double LimMin(double a, double b){return a < b ? a : b;}
+static inline double LimMax(double a, double b){return a > b ? a : b;}
+
+template <int LIM> static inline double Limit(double a, double b){
+
+	double aa = fabs(a);
+	double ab = fabs(b);
+	double s = 0.5*(copysign(1., a) + copysign(1., b)); // +-1 for equal signs, else 0
+
+	if constexpr(LIM == LIM_VANLEER){
+		double d = aa + ab;
+		return (a*ab + aa*b)/(d + (d == 0)); // a = b = 0 divides 0 by 1
+	}
+	else if constexpr(LIM == LIM_MINMOD){
+		return s*LimMin(aa, ab);
+	}
+	else if constexpr(LIM == LIM_MC){
+		return s*LimMin(LimMin(2*aa, 2*ab), 0.5*fabs(a + b));
+	}
+	else{
+		return s*LimMax(LimMin(2*aa, ab), LimMin(aa, 2*ab));
+	}
+}
+
+// Limiter chosen at run time, for code outside the per-limiter kernels.
+static inline double LimitSelect(int lim, double a, double b){
+
+	if(lim == LIM_MINMOD){return Limit<LIM_MINMOD>(a, b);}
+	if(lim == LIM_MC){return Limit<LIM_MC>(a, b);}
+	if(lim == LIM_SUPERBEE){return Limit<LIM_SUPERBEE>(a, b);}
+	return Limit<LIM_VANLEER>(a, b);
+}
+
+// Limited slope at C from its neighbours L and R. On a uniform axis (rh = 1/spacing > 0) the limiters are
+// homogeneous of degree one, phi(a/h, b/h) = phi(a, b)/h, so the differences are limited and scaled once
+// and the coordinates are not read. Otherwise the slopes come from the cell centers xL, xC, xR, with the
+// periodic wrap of a unit domain; a neighbour at the cell's own center (a clamped boundary) gives zero.
+template <int LIM> static inline double LimitedSlope(double L, double C, double R, double xL, double xC, double xR, double rh){
+
+	if(rh > 0){return Limit<LIM>(C - L, R - C)*rh;}
+
+	xR += (xR < xC);
+	xL -= (xL > xC);
+	double dL = xC - xL;
+	double dR = xR - xC;
+	return Limit<LIM>((C - L)/(dL + (dL == 0)), (R - C)/(dR + (dR == 0)));
+}
+
+#endif
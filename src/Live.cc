@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "Live.hh"
+
+static_assert(sizeof(LiveHeader) <= LIVE_HEADER_BYTES, "LiveHeader does not fit in LIVE_HEADER_BYTES");
+
+int LiveInit(Live* L, int every, int stride, int* N, int effD){
+
+	if(stride < 1){stride = 1;}
+
+	L->every = every;
+	L->last = -1;
+	L->effD = effD;
+	L->count = 0;
+	L->seconds = 0;
+
+	int n[3] = {1, 1, 1};
+	for(int d = 0; d < effD; d++){n[d] = (N[d] + stride - 1)/stride;}
+	L->ncells = (long)n[0]*n[1]*n[2];
+	L->sidx = new int[L->ncells];
+	for(int k = 0; k < n[2]; k++){
+		for(int j = 0; j < n[1]; j++){
+			for(int i = 0; i < n[0]; i++){
+				L->sidx[i + n[0]*j + (long)n[0]*n[1]*k] = i*stride + N[0]*j*stride + N[0]*N[1]*k*stride;
+			}
+		}
+	}
+
+	int nvar = 2 + effD;
+	L->bytes = LIVE_HEADER_BYTES + 2*nvar*L->ncells*(long)sizeof(double);
+	snprintf(L->name, LIVE_NAME, "/cdugks_%d", (int)getpid());
+	L->fd = shm_open(L->name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(L->fd < 0){printf("Cannot create shared memory %s\n", L->name); delete[] L->sidx; return 0;}
+	if(ftruncate(L->fd, L->bytes) != 0){printf("Cannot grow %s to %ld bytes\n", L->name, L->bytes); shm_unlink(L->name); close(L->fd); delete[] L->sidx; return 0;}
+	void* p = mmap(NULL, L->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, L->fd, 0);
+	if(p == MAP_FAILED){printf("Cannot map %s\n", L->name); shm_unlink(L->name); close(L->fd); delete[] L->sidx; return 0;}
+
+	//The segment is zero filled, so both slots start even and unpublished
+	L->h = (LiveHeader*)p;
+	L->data = (double*)((char*)p + LIVE_HEADER_BYTES);
+	LiveHeader* h = L->h;
+	h->version = LIVE_VERSION;
+	h->effD = effD;
+	for(int d = 0; d < 3; d++){h->N[d] = N[d]; h->n[d] = n[d];}
+	h->stride = stride;
+	h->nvar = nvar;
+	h->done = 0;
+	h->latest = -1;
+	h->ncells = L->ncells;
+	h->pid = getpid();
+	h->published = 0;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(h->magic, LIVE_MAGIC, 8); // Last, a reader that sees the magic sees the rest of the header
+	return 1;
+}
+
+void LiveFree(Live* L){
+
+	__atomic_store_n(&L->h->done, 1, __ATOMIC_RELEASE);
+	munmap(L->h, L->bytes);
+	close(L->fd);
+	shm_unlink(L->name);
+	delete[] L->sidx;
+}
+
+void LiveStep(Live* L, double* rho, double* rhov, double* rhoE, int iter, double Tsim, double dt){
+
+	if(L->last >= 0 && iter - L->last < L->every){return;}
+	L->last = iter;
+	auto t0 = std::chrono::steady_clock::now();
+
+	LiveHeader* h = L->h;
+	int effD = L->effD;
+	long nc = L->ncells;
+	int k = (h->latest + 1)&1; // The buffer not published last
+	LiveSlot* s = &h->slot[k];
+	double* out = L->data + k*(2 + effD)*nc;
+
+	//Seqlock: odd before any of the buffer changes, even again once all of it has
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	s->published = h->published + 1;
+	s->iter = iter;
+	s->Tsim = Tsim;
+	s->dt = dt;
+	for(long c = 0; c < nc; c++){
+		int sidx = L->sidx[c];
+		out[c] = rho[sidx];
+		for(int d = 0; d < effD; d++){out[(1 + d)*nc + c] = rhov[effD*sidx + d];}
+		out[(1 + effD)*nc + c] = rhoE[sidx];
+	}
+
+	__atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&h->latest, k, __ATOMIC_RELEASE);
+	__atomic_store_n(&h->published, h->published + 1, __ATOMIC_RELEASE);
+
+	L->count++;
+	L->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,36 @@
+#ifndef LIVE_HH
+#define LIVE_HH
+
+#include "LiveFormat.hh"
+
+// Live monitoring (-j every, -v stride): every <every> timesteps, after Step 4/5, the conserved fields of every
+// stride-th cell along each active axis are published to shared memory (LiveFormat.hh), with the timestep,
+// Tsim and dt. A publication copies the published cells only and never waits for readers.
+// The segment is unlinked at the end of the run; readers that have it mapped keep it and see done set.
+
+struct Live{
+
+	int every;        // Steps between publications
+	int last;         // Step of the last publication
+	int effD;
+	long ncells;
+	int* sidx;        // Spatial index of each published cell
+
+	char name[LIVE_NAME];
+	int fd;
+	long bytes;
+	LiveHeader* h;
+	double* data;     // Buffer 0, buffer 1 follows
+
+	long count;       // Publications
+	double seconds;   // Time spent publishing
+};
+
+// Create /cdugks_<pid>. Returns 0 on failure.
+int LiveInit(Live* L, int every, int stride, int* N, int effD);
+void LiveFree(Live* L);
+
+// After each step (after each block when blocking): publish if due.
+void LiveStep(Live* L, double* rho, double* rhov, double* rhoE, int iter, double Tsim, double dt);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef LIVEFORMAT_HH
+#define LIVEFORMAT_HH
+
+// Live state published by the C++ solver (-j every) to the POSIX shared memory segment /cdugks_<pid>
+// (/dev/shm/cdugks_<pid> on Linux), plain C so readers in other languages can follow it (src/live.py).
+// A LIVE_HEADER_BYTES header is followed by two buffers of nvar*ncells doubles, buffer k at
+// LIVE_HEADER_BYTES + k*nvar*ncells*8. Variable v of published cell c is at [v*ncells + c], the variables
+// are rho, rhov[0..effD-1], rhoE, and the published cells are i = 0, stride, 2*stride, ... of each
+// active axis, c = i/stride + n[0]*(j/stride) + n[0]*n[1]*(k/stride).
+//
+// The solver writes into the buffer it did not publish last, so a reader copying the latest one is only
+// disturbed if two more publications start during its copy. Each buffer is guarded by a seqlock: its seq
+// is odd while it is written. A reader takes k = latest, reads slot[k].seq (retrying while it is odd),
+// copies slot[k] and buffer k, and keeps the copy if slot[k].seq is unchanged after it (LiveReader.hh).
+// published counts the publications, so readers can tell a new state from the one they already have. The
+// slot keeps the count of the state in its buffer: the header count and latest are not read together, so a
+// reader records the count from its copy of the slot, never the header's.
+
+#include <stdint.h>
+
+#define LIVE_MAGIC "CDUGKSLV"
+#define LIVE_VERSION 1
+#define LIVE_HEADER_BYTES 256
+#define LIVE_NAME 64
+
+struct LiveSlot{
+
+	uint64_t seq;     // Odd while the buffer is being written
+	uint64_t published; // Publication count of the state in the buffer
+	int64_t iter;     // Timestep of the state in the buffer
+	double Tsim;
+	double dt;
+};
+
+struct LiveHeader{
+
+	char magic[8];    // LIVE_MAGIC, not terminated
+	int32_t version;  // LIVE_VERSION
+	int32_t effD;
+	int32_t N[3];     // Grid of the run
+	int32_t n[3];     // Published grid, ceil(N/stride) on active axes
+	int32_t stride;
+	int32_t nvar;     // 2 + effD
+	int32_t done;     // Set when the run ends
+	int32_t latest;   // Buffer of the last publication, -1 before the first
+	int64_t ncells;   // n[0]*n[1]*n[2]
+	int64_t pid;      // Of the solver
+	uint64_t published;
+
+	LiveSlot slot[2];
+};
+
+#endif
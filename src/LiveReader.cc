@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "LiveReader.hh"
+
+int LiveOpen(LiveReader* R, const char* name){
+
+	R->fd = shm_open(name, O_RDONLY, 0);
+	if(R->fd < 0){printf("No live segment %s\n", name); return 0;}
+
+	struct stat st;
+	if(fstat(R->fd, &st) != 0 || st.st_size < LIVE_HEADER_BYTES){printf("%s is not a live segment\n", name); close(R->fd); return 0;}
+	R->bytes = st.st_size;
+	void* p = mmap(NULL, R->bytes, PROT_READ, MAP_SHARED, R->fd, 0);
+	if(p == MAP_FAILED){printf("Cannot map %s\n", name); close(R->fd); return 0;}
+
+	R->h = (const LiveHeader*)p;
+	R->data = (const double*)((const char*)p + LIVE_HEADER_BYTES);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if(memcmp(R->h->magic, LIVE_MAGIC, 8) != 0 || R->h->version != LIVE_VERSION || R->bytes < LIVE_HEADER_BYTES + 2*R->h->nvar*R->h->ncells*(long)sizeof(double)){
+		printf("%s is not a live segment of version %d\n", name, LIVE_VERSION);
+		munmap(p, R->bytes);
+		close(R->fd);
+		return 0;
+	}
+
+	R->seen = 0;
+	R->buf = new double[R->h->nvar*R->h->ncells];
+	return 1;
+}
+
+void LiveClose(LiveReader* R){
+
+	munmap((void*)R->h, R->bytes);
+	close(R->fd);
+	delete[] R->buf;
+}
+
+int LiveDone(const LiveReader* R){
+
+	return __atomic_load_n(&R->h->done, __ATOMIC_ACQUIRE);
+}
+
+int LiveRead(LiveReader* R, LiveFrame* F){
+
+	const LiveHeader* h = R->h;
+	long nc = h->ncells;
+	int nvar = h->nvar;
+
+	for(int attempt = 0; attempt < LIVE_RETRIES; attempt++){
+		int k = __atomic_load_n(&h->latest, __ATOMIC_ACQUIRE);
+		if(k < 0 || __atomic_load_n(&h->published, __ATOMIC_ACQUIRE) == R->seen){return 0;}
+
+		const LiveSlot* s = &h->slot[k];
+		uint64_t s1 = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+		if(s1 & 1){continue;} // Being rewritten, the other buffer is the latest by now
+
+		LiveSlot meta = *s;
+		memcpy(R->buf, R->data + k*nvar*nc, nvar*nc*sizeof(double));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&s->seq, __ATOMIC_RELAXED) != s1){continue;}
+		if(meta.published == R->seen){return 0;} // Published after the header was read, but this frame was already returned
+
+		R->seen = meta.published;
+		F->iter = meta.iter;
+		F->Tsim = meta.Tsim;
+		F->dt = meta.dt;
+		F->effD = h->effD;
+		for(int d = 0; d < 3; d++){F->n[d] = h->n[d];}
+		F->stride = h->stride;
+		F->ncells = nc;
+		F->rho = R->buf;
+		for(int d = 0; d < 3; d++){F->rhov[d] = (d < h->effD) ? R->buf + (1 + d)*nc : NULL;}
+		F->rhoE = R->buf + (1 + h->effD)*nc;
+		return 1;
+	}
+	return 0;
+}
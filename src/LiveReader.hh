@@ -0,0 +1,58 @@
+#ifndef LIVEREADER_HH
+#define LIVEREADER_HH
+
+#include "LiveFormat.hh"
+
+// Reader of the live state a run publishes (LiveFormat.hh), for monitors in other processes. Link LiveReader.cc;
+// it needs nothing else from the solver.
+//
+//   LiveReader R;
+//   LiveFrame F;
+//   if(LiveOpen(&R, "/cdugks_1234")){
+//     while(!LiveDone(&R)){
+//       if(LiveRead(&R, &F)){... F.iter, F.Tsim, F.rho[c], F.rhov[d][c], F.rhoE[c] ...}
+//       usleep(100000);
+//     }
+//     LiveClose(&R);
+//   }
+//
+// Reads never block the solver. A copy that the solver overwrote while it was taken is detected and retaken.
+
+#define LIVE_RETRIES 64 // Attempts at a consistent copy before LiveRead gives up
+
+struct LiveReader{
+
+	int fd;
+	long bytes;
+	const LiveHeader* h;
+	const double* data;
+	uint64_t seen;        // Publication count of the last frame returned
+	double* buf;          // Frame storage
+};
+
+struct LiveFrame{
+
+	long iter;
+	double Tsim;
+	double dt;
+	int effD;
+	int n[3];             // Published grid, cell c = i + n[0]*j + n[0]*n[1]*k
+	int stride;           // Published cell (i, j, k) is cell (stride*i, stride*j, stride*k) of the run
+	long ncells;
+	const double* rho;    // Into the reader's storage, valid until the next LiveRead
+	const double* rhov[3];
+	const double* rhoE;
+};
+
+// Map the segment name ("/cdugks_<pid>", printed by the solver). Returns 0 if it does not exist or is not a live segment.
+int LiveOpen(LiveReader* R, const char* name);
+void LiveClose(LiveReader* R);
+
+// Copy the latest publication into F. Returns 1 for a publication newer than the last one returned, 0 if there
+// is none yet, nothing new, or no consistent copy could be taken in LIVE_RETRIES attempts.
+int LiveRead(LiveReader* R, LiveFrame* F);
+
+// The run has ended, nothing more will be published.
+int LiveDone(const LiveReader* R);
+
+#endif
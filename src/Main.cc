@@ -8,87 +8,155 @@
 #include "testProblem.hh"
 #include "Functions.hh"
 #include "Evolution.hh"
-
-int main(){
-
-	int testProblem = 2; //0 is None, 1 is Sod Shock, 2 is KHI, 3 is RTI.
-	if (testProblem > 0){TestProblem(N, NV, &Nc, &Nv, BCs, Vmin, Vmax, testProblem, &R, &K, &Cv, &gma, &w , &ur, &Tr, &Pr, &effD);}
+#include "Blocking.hh"
+#include "Sweep.hh"
+#include "Tiles.hh"
+#include "Hybrid.hh"
+#include "Dormant.hh"
+#include "OutOfCore.hh"
+#include "Config.hh"
+#include "Health.hh"
+#include "InitialConditions.hh"
+#include "Output.hh"
+#include "Live.hh"
+
+int main(int argc, char** argv){
+
+	Config config;
+	ConfigFromCommand(&config, argc, argv);
+
+	int testProblem = config.testproblem; //0 is None, 1 is Sod Shock, 2 is KHI, 3 is RTI.
+	ICFile ic;
+	double icTf = 0.15;
+	double icdtdump = icTf/200.;
+	if(config.icfile != NULL){
+		if(ICOpen(&ic, config.icfile) == 0){return 1;}
+		testProblem = 0;
+		ICParameters(&ic, N, NV, &Nc, &Nv, BCs, Vmin, Vmax, &R, &K, &Cv, &gma, &w , &ur, &Tr, &Pr, &effD, &icTf, &icdtdump);
+	}
+	else if (testProblem > 0){TestProblem(N, NV, &Nc, &Nv, BCs, Vmin, Vmax, testProblem, &R, &K, &Cv, &gma, &w , &ur, &Tr, &Pr, &effD);}
 	else{
 		//TODO Non Test Problems
 	}
 
+	//Resolution override: the most resolved axes get config.cells cells, thin axes (1 or 2 cells) keep theirs
+	if(config.cells > 0 && testProblem > 0){
+		int Nmax = N[0] > N[1] ? (N[0] > N[2] ? N[0] : N[2]) : (N[1] > N[2] ? N[1] : N[2]);
+		for(int d = 0; d < 3; d++){if(N[d] == Nmax){N[d] = config.cells;}}
+		Nc = N[0]*N[1]*N[2];
+	}
+	if(config.cells > 0 && testProblem == 0){printf("-m only applies to the test problems, using the resolution of %s\n", config.icfile);}
+
 
 	printf("N = {%d, %d, %d}, effD = %d\n", N[0], N[1], N[2], effD);
 	printf("NV = {%d, %d, %d}\n", NV[0], NV[1], NV[2]);
 	printf("R = %f,  K = %f, Cv = %f,  g = %f\n", R, K, Cv, gma);
 	printf("w = %f, ur = %f, Tr = %f, Pr = %f\n", w, ur, Tr, Pr);
 	printf("Confirm Parameters, Enter/Return to Continue:\n");
-	getchar();
+	if(config.interactive){getchar();}
+
 
+	//Out-of-core step: g and b in files, the other phase space arrays only for a slab (OutOfCore.hh)
+	int outofcore = (config.ooc != NULL && !config.split && config.block == 0 && config.slabs == 0 && config.hybrid == 0 && config.dormant == 0);
+	if(config.ooc != NULL && !outofcore){printf("The out-of-core step does not combine with -x, -b, -g, -y or -e, running in memory\n");}
 
 	int numdoub = 0;
-	numdoub += Nc*Nv;   //g and b are reduced distrubution functions (Vel and E distribution)
-        numdoub += Nc*Nv;
-        numdoub += Nc*Nv;   //gbarp and bbarp are reduced distrubution functions (Vel and E distribution)
-        numdoub += Nc*Nv;
+	if(!outofcore){
+		numdoub += Nc*Nv;   //g and b are reduced distrubution functions (Vel and E distribution)
+		numdoub += Nc*Nv;
+		numdoub += Nc*Nv;   //gbarp and bbarp are reduced distrubution functions (Vel and E distribution)
+		numdoub += Nc*Nv;
+	}
 
-	numdoub += Nc*Nv*effD; // gbar/p and bbar/p are reduced distrubution functions (Vel and E distribution)
-        numdoub += Nc*Nv*effD;
-        numdoub += Nc*Nv*effD;
-        numdoub += Nc*Nv*effD;
+	if(!config.split && !outofcore){
+		numdoub += Nc*Nv*effD; // gbar/p and bbar/p are reduced distrubution functions (Vel and E distribution)
+		numdoub += Nc*Nv*effD;
+		numdoub += Nc*Nv*effD;
+		numdoub += Nc*Nv*effD;
+	}
 
 
-        numdoub += Nc; //Source Terms
-        numdoub += Nc*Nv;
+        numdoub += Nc*effD; //Source Terms
+        numdoub += 2*Nc;
 
         numdoub += Nc;    //Conserved Variables at t
         numdoub += Nc*effD;
         numdoub += Nc;
-        numdoub += Nc*effD;  //Conserved Variables at t + h, at interfaces
-        numdoub += Nc*effD*effD;
-        numdoub += Nc*effD;
-
-        numdoub += Nc*Nv*effD;//Gradients
-        numdoub += Nc*Nv*effD;
-        numdoub += Nc*Nv*effD*effD;
-        numdoub += Nc*Nv*effD*effD;
+	if(!config.split && !outofcore){
+		numdoub += Nc*effD;  //Conserved Variables at t + h, at interfaces
+		numdoub += Nc*effD*effD;
+		numdoub += Nc*effD;
+
+		numdoub += Nc*Nv*effD;//Gradients
+		numdoub += Nc*Nv*effD;
+		numdoub += Nc*Nv*effD*effD;
+		numdoub += Nc*Nv*effD*effD;
+	}
+	else if(config.split){
+		numdoub += 6*Nc*Nv; //Sweep interface values and slopes, one axis at a time
+		numdoub += Nc*(2 + effD);
+	}
 
 	printf("Total Number of Doubles = %d\n", numdoub);
-	getchar();
+	if(config.interactive){getchar();}
 
 	//Declare Physical Quantities
 	printf("Declaring Variables\n");
-	double* g = new double[Nc*Nv];   //g and b are reduced distrubution functions (Vel and E distribution)
-	double* b = new double[Nc*Nv];
-	double* gbarp = new double[Nc*Nv];   //gbarp and bbarp are reduced distrubution functions (Vel and E distribution)
-	double* bbarp = new double[Nc*Nv];
+	double* g = NULL;   //g and b are reduced distrubution functions (Vel and E distribution)
+	double* b = NULL;
+	double* gbarp = NULL;   //gbarp and bbarp are reduced distrubution functions (Vel and E distribution)
+	double* bbarp = NULL;
+	OutOfCore ooc;
+	if(outofcore){
+		if(OOCInit(&ooc, config.ooc, config.tile, N, NV, effD, BCs) == 0){return 1;}
+		g = ooc.g;
+		b = ooc.b;
+		printf("Out of core: g and b mapped from %s, %d slabs of up to %d rows, %.1f MB of windows\n", config.ooc, ooc.n, ooc.L, (double)ooc.layer*ooc.L*Nv*(6 + 6*effD + 2*effD*effD)*sizeof(double)/1e6);
+	}
+	else{
+		g = new double[Nc*Nv];
+		b = new double[Nc*Nv];
+		gbarp = new double[Nc*Nv];
+		bbarp = new double[Nc*Nv];
+	}
 	printf("Declared Reduced Distribution Functions\n");
 
-	//At interface
-	double* gbarpbound = new double[Nc*Nv*effD]; // gbar/p and bbar/p are reduced distrubution functions (Vel and E distribution)
-	double* bbarpbound = new double[Nc*Nv*effD];
-	double* gbar = new double[Nc*Nv*effD];
-	double* bbar = new double[Nc*Nv*effD];
-	printf("Declared Interface Reduced Distribution Functions\n");
-
-	double* Sg = new double[Nc]; //Source Terms
-	double* Sb = new double[Nc];
-	printf("Declared Soure Terms\n");
-
 	double* rho = new double[Nc];   //Conserved Variables at t
 	double* rhov = new double[Nc*effD];
 	double* rhoE = new double[Nc];
-	double* rhoh = new double[Nc*effD]; //Conserved Variables at t + h, at interfaces
-	double* rhovh = new double[Nc*effD*effD];
-	double* rhoEh = new double[Nc*effD];
 	printf("Declared Conserved Variable Arrays\n");
 
-	double* gsigma = new double[Nc*Nv*effD]; // Gradients
-	double* bsigma = new double[Nc*Nv*effD];
-	printf("Declared Gradient Arrays\n");
-	double* gsigma2 = new double[Nc*Nv*effD*effD];
-	double* bsigma2 = new double[Nc*Nv*effD*effD];
-	printf("Declared Second Gradient Arrays\n");
+	//Unsplit step only, the split sweeps keep one axis of these in Sweep
+	double* gbarpbound = NULL;
+	double* bbarpbound = NULL;
+	double* gbar = NULL;
+	double* bbar = NULL;
+	double* rhoh = NULL;
+	double* rhovh = NULL;
+	double* rhoEh = NULL;
+	double* gsigma = NULL;
+	double* bsigma = NULL;
+	double* gsigma2 = NULL;
+	double* bsigma2 = NULL;
+	if(!config.split && !outofcore){
+		//At interface
+		gbarpbound = new double[Nc*Nv*effD]; // gbar/p and bbar/p are reduced distrubution functions (Vel and E distribution)
+		bbarpbound = new double[Nc*Nv*effD];
+		gbar = new double[Nc*Nv*effD];
+		bbar = new double[Nc*Nv*effD];
+		printf("Declared Interface Reduced Distribution Functions\n");
+
+		rhoh = new double[Nc*effD]; //Conserved Variables at t + h, at interfaces
+		rhovh = new double[Nc*effD*effD];
+		rhoEh = new double[Nc*effD];
+
+		gsigma = new double[Nc*Nv*effD]; // Gradients
+		bsigma = new double[Nc*Nv*effD];
+		printf("Declared Gradient Arrays\n");
+		gsigma2 = new double[Nc*Nv*effD*effD];
+		bsigma2 = new double[Nc*Nv*effD*effD];
+		printf("Declared Second Gradient Arrays\n");
+	}
 
 
 	//Flux
@@ -105,6 +173,10 @@ int main(){
 	double* Co_WZ = new double[NV[2]];
 	Cotes(Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ);
 
+	//Velocity moments basis, shared by initialization, Step 2a and Step 4
+	MomentBasis moments;
+	MomentsInit(&moments, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, NV, effD, config.repro);
+
 	//Checking NC Weights on 128-cell Sod Problem
 	//for(int i = 0; i < 128; i++){printf("Main.cc Co_X[%d] = %f\n", i, Co_X[i]);}
 	//for(int i = 0; i < 128; i++){printf("Main.cc Co_WX[%d] = %f\n", i, Co_WX[i]);}
@@ -112,18 +184,57 @@ int main(){
 	//Generate Mesh: Grid Cell Centers and Sizes
 	printf("Generating Mesh\n");
 	int MeshType = 1; // 0 is UserDefinedMesh, 1 is RectangularMesh, 2 is Nested Rectangular Mesh.
-	struct Cell mesh[N[0]*N[1]*N[2]];
+	Cell* mesh = new Cell[N[0]*N[1]*N[2]];
 	Mesh(N, mesh, MeshType);
+	double rh[3];
+	MeshUniform(N, mesh, rh);
+
+
+	//Kernels specialized for the dimensionality and boundary conditions
+	StepKernels kernels;
+	if(config.limiter < 0 || config.limiter >= LIM_COUNT){printf("Unknown slope limiter %d\n", config.limiter); return 1;}
+	SelectStepKernels(&kernels, effD, BCs, config.limiter, rh);
+	for(int d = effD; d < 3; d++){assert(NV[d] == 1);}
+
+	//Directionally split sweeps
+	Sweep sweep;
+	if(config.split){
+		SweepInit(&sweep, N, NV, effD, BCs, config.limiter, rh);
+		printf("Split sweeps: %d per timestep\n", sweep.n);
+	}
+
+
+	//Source Terms
+	printf("Setting up Source Terms\n");
+	Source source;
+	SourceInit(&source, N, effD);
+	if(config.gravity != 0){
+		double g0[3] = {0, 0, 0};
+		g0[effD-1] = config.gravity;
+		SourceConstantGravity(&source, g0, N, effD);
+	}
+	if(config.icfile != NULL && ic.phi != NULL){SourcePotentialGravity(&source, ic.phi, mesh, N, BCs, effD);}
+	SourceHeating(&source, config.heating);
+	if(config.cooling != NULL && SourceLoadCooling(&source, config.cooling) == 0){return 1;}
 
 
 	//Initialize Grid
 	printf("Initializing Grid on Mesh\n");
 	if (testProblem > 0){
 
-		InitializeTestProblem(mesh, g, b, rho, rhov, rhoE, testProblem, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
+		InitializeTestProblem(mesh, g, b, rho, rhov, rhoE, testProblem, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, &moments, config.threads);
 
 		printf("Confirm Initial Conditions, Enter/Return to Continue:\n");
-		getchar();
+		if(config.interactive){getchar();}
+	}
+	else if(config.icfile != NULL){
+
+		ICLoad(&ic, g, b, rho, rhov, rhoE, Co_X, Co_Y, Co_Z, R, K, N, NV, effD, config.threads);
+		ICClose(&ic);
+		CheckInitialMoments(g, b, rho, rhov, rhoE, &moments, N, effD);
+
+		printf("Confirm Initial Conditions, Enter/Return to Continue:\n");
+		if(config.interactive){getchar();}
 	}
 	else{
 		//TODO
@@ -149,17 +260,113 @@ int main(){
 		*Tf = 2.0;
 		*dtdump = *Tf/400.;
 	}
+	if(config.icfile != NULL){
+		*Tf = icTf;
+		*dtdump = icdtdump;
+	}
+
 
 
+	//Temporal blocking, 1D only
+	int blocked = (config.block > 0 && effD == 1);
+	if(config.block > 0 && effD != 1){printf("Temporal blocking is only supported for 1D problems, running unblocked\n");}
+	Blocking blocking;
+	double* dts = new double[config.block > 0 ? config.block : 1];
+	if(blocked){
+		BlockingInit(&blocking, config.block, config.tile, N, NV, config.limiter, rh);
+		printf("Temporal blocking: %d timesteps per block, %d cells per tile\n", config.block, config.tile);
+	}
+
+	//Output selection: boxes, slices and probes
+	Output output;
+	OutputInit(&output);
+	if(config.select != NULL && OutputLoad(&output, config.select, N) == 0){return 1;}
+	int selected = (output.nbox > 0 || output.nprobe > 0);
+
+	//Live state in shared memory
+	int live = (config.live > 0);
+	Live monitor;
+	if(live){
+		if(LiveInit(&monitor, config.live, config.livestride, N, effD) == 0){return 1;}
+		printf("Live state: %s every %d timesteps, %ld cells\n", monitor.name, config.live, monitor.ncells);
+	}
+
+	//Hybrid continuum/kinetic step
+	int hybrid = (config.hybrid > 0 && !config.split && !blocked && config.slabs == 0);
+	if(config.hybrid > 0 && !hybrid){printf("The hybrid step does not apply to split sweeps, temporal blocking or the tiled step, running without it\n");}
+	Hybrid hyb;
+	if(hybrid){
+		HybridInit(&hyb, config.hybrid, N, effD);
+		printf("Hybrid step: rows below Kn = %g take the Navier-Stokes update\n", config.hybrid);
+	}
+
+	//Dormant rows
+	int dormant = (config.dormant > 0 && !config.split && !blocked && config.slabs == 0 && !hybrid);
+	if(config.dormant > 0 && !dormant){printf("Dormant rows do not apply to split sweeps, temporal blocking, the tiled or the hybrid step, running without them\n");}
+	Dormant dorm;
+	if(dormant){
+		DormantInit(&dorm, config.dormant, N, effD);
+		printf("Dormant rows: skipped while their neighbourhood changes by less than %g\n", config.dormant);
+	}
+
+	//Tiled task graph step
+	int tiled = (config.slabs > 0 && !config.split && !blocked);
+	if(config.slabs > 0 && !tiled){printf("The tiled step does not apply to split sweeps or temporal blocking, running without it\n");}
+	Tiles tiles;
+	if(tiled){
+		TilesInit(&tiles, config.slabs, config.threads, N, NV, effD, BCs, &moments);
+		printf("Tiled step: %d slabs, %d threads\n", tiles.n, tiles.nthreads);
+	}
 
 	int iter = 0;
 	int dumpiter = 0;
-	datadeal(mesh, rho, dumpiter, testProblem);
+	int checked = 0; //Iteration of the last health check
+	if(config.out){datadeal(mesh, rho, dumpiter, testProblem);}
+	if(selected){OutputStep(&output, rho, rhov, rhoE, iter, *Tsim, effD);}
+	if(live){LiveStep(&monitor, rho, rhov, rhoE, iter, *Tsim, 0);}
 	printf("Entering Evolution Loop\n");
-	while(*Tsim < *Tf){ // && iter < itermax
+	while(*Tsim < *Tf && blocked && (config.steps == 0 || iter < config.steps)){
+		int dump;
+		int steps = EvolveBlocked(&blocking, &g, &b, &rho, &rhov, &rhoE, dts, &dump, config.steps - iter, *Tf, *Tsim, *dtdump, *Tdump, mesh, Co_X, Co_Y, Co_Z, &moments, &source, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);
+
+		for(int s = 0; s < steps; s++){
+			iter++;
+			*dt = dts[s];
+			*Tsim += *dt;
+			*Tdump += *dt;
+			if(dump == 1 && s == steps - 1){
+				*Tdump = 0.0;
+				dumpiter++;
+				if(config.out){datadeal(mesh, rho, dumpiter, testProblem);}
+			}
+			printf("iteration = %d, timestep = %f, Tsim = %f, Tdump = %f, dtdump = %f, dumpiter = %d\n", iter, *dt, *Tsim, *Tdump, *dtdump, dumpiter);
+		}
+		//The state is only complete at the end of a block, so probes are recorded once per block
+		if(selected){OutputStep(&output, rho, rhov, rhoE, iter, *Tsim, effD);}
+		if(live){LiveStep(&monitor, rho, rhov, rhoE, iter, *Tsim, *dt);}
+
+		if(config.health > 0 && (iter - checked >= config.health || *Tsim >= *Tf)){
+			checked = iter;
+			if(!HealthCheck(g, b, rho, rhov, rhoE, iter, *Tsim, Co_X, Co_Y, Co_Z, N, NV, effD)){
+				dumpiter++;
+				datadeal(mesh, rho, dumpiter, testProblem);
+				OutputFlush(&output);
+				if(tiled){TilesFree(&tiles);}
+				if(live){LiveFree(&monitor);}
+				return 1;
+			}
+		}
+	}
+	while(*Tsim < *Tf && (config.steps == 0 || iter < config.steps)){
 		iter++;
 
-		int dump = Evolve(g, b, gbar, bbar, gbarp, bbarp, Sg, Sb, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, rhoh, rhovh, rhoEh, Tdump, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);
+		int dump;
+		if(config.split){dump = EvolveSplit(&sweep, g, b, gbarp, bbarp, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, mesh, Tdump, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
+		else if(dormant){dump = EvolveDormant(&dorm, g, b, gbar, bbar, gbarp, bbarp, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, rhoh, rhovh, rhoEh, Tdump, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
+		else if(hybrid){dump = EvolveHybrid(&hyb, g, b, gbar, bbar, gbarp, bbarp, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, rhoh, rhovh, rhoEh, Tdump, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
+		else if(outofcore){dump = EvolveOutOfCore(&ooc, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, mesh, Tdump, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
+		else if(tiled){dump = EvolveTiled(&tiles, g, b, gbar, bbar, gbarp, bbarp, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, rhoh, rhovh, rhoEh, Tdump, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
+		else{dump = Evolve(g, b, gbar, bbar, gbarp, bbarp, &source, rho, rhov, rhoE, dt, *Tf, *Tsim, *dtdump, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, &moments, &kernels, gsigma, bsigma, gsigma2, bsigma2, mesh, gbarpbound, bbarpbound, rhoh, rhovh, rhoEh, Tdump, BCs, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, Vmax);}
 
 		*Tsim += *dt;
 		*Tdump += *dt;
@@ -167,9 +374,38 @@ int main(){
 		if(dump == 1){
 			*Tdump = 0.0;
 			dumpiter++;
-			datadeal(mesh, rho, dumpiter, testProblem);
+			if(config.out){datadeal(mesh, rho, dumpiter, testProblem);}
+			if(hybrid){printf("Hybrid step: %d of %d rows kinetic\n", hyb.nkinetic, hyb.nrow);}
+			if(dormant){printf("Dormant rows: %d of %d awake\n", dorm.nawake, dorm.nrow);}
+			if(outofcore){printf("Out of core: %.2f s waiting for slab I/O\n", ooc.stall);}
 		}
+		if(selected){OutputStep(&output, rho, rhov, rhoE, iter, *Tsim, effD);}
+		if(live){LiveStep(&monitor, rho, rhov, rhoE, iter, *Tsim, *dt);}
 		printf("iteration = %d, timestep = %f, Tsim = %f, Tdump = %f, dtdump = %f, dumpiter = %d\n", iter, *dt, *Tsim, *Tdump, *dtdump, dumpiter);
+
+		if(config.health > 0 && (iter - checked >= config.health || *Tsim >= *Tf)){
+			checked = iter;
+			if(!HealthCheck(g, b, rho, rhov, rhoE, iter, *Tsim, Co_X, Co_Y, Co_Z, N, NV, effD)){
+				dumpiter++;
+				datadeal(mesh, rho, dumpiter, testProblem);
+				OutputFlush(&output);
+				if(tiled){TilesFree(&tiles);}
+				if(live){LiveFree(&monitor);}
+				return 1;
+			}
+		}
+	}
+
+	OutputFlush(&output);
+	OutputFree(&output);
+	if(tiled){TilesFree(&tiles);}
+	if(hybrid){HybridFree(&hyb);}
+	if(dormant){DormantFree(&dorm);}
+	if(outofcore){OOCFree(&ooc);}
+	SourceFree(&source);
+	if(live){
+		printf("Live state: %ld publications, %.1f us each\n", monitor.count, 1e6*monitor.seconds/(monitor.count > 0 ? monitor.count : 1));
+		LiveFree(&monitor);
 	}
 
 	//show data
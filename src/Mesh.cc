@@ -51,4 +51,30 @@ void Mesh(int* N, Cell* mesh, int MeshType){
 	else if(MeshType == 2){
 		//TODO
 	}
-}
\ No newline at end of file
+}
+
+// An axis is uniform when every cell has the same width along it and neighbouring centers are one width apart
+// (to roundoff); the slope limiters then work on differences scaled by rh = 1/width.
+void MeshUniform(int* N, Cell* mesh, double* rh){
+
+	int Nx = N[0];
+	int Ny = N[1];
+	int Nz = N[2];
+	int stride[3] = {1, Nx, Nx*Ny};
+
+	for(int d = 0; d < 3; d++){
+		double h = (d == 0) ? mesh[0].dx : ((d == 1) ? mesh[0].dy : mesh[0].dz);
+		int uniform = (h > 0);
+		for(int idx = 0; idx < Nx*Ny*Nz && uniform; idx++){
+			int p = (d == 0) ? idx%Nx : ((d == 1) ? (idx/Nx)%Ny : idx/(Nx*Ny));
+			double w = (d == 0) ? mesh[idx].dx : ((d == 1) ? mesh[idx].dy : mesh[idx].dz);
+			if(w != h){uniform = 0;}
+			if(p > 0){
+				int l = idx - stride[d];
+				double x = (d == 0) ? mesh[idx].x - mesh[l].x : ((d == 1) ? mesh[idx].y - mesh[l].y : mesh[idx].z - mesh[l].z);
+				if(fabs(x - h) > 1e-10*h){uniform = 0;}
+			}
+		}
+		rh[d] = uniform ? 1.0/h : 0.0;
+	}
+}
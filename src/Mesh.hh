@@ -18,4 +18,7 @@ struct Cell{
 
 
 void Mesh(int* N, Cell* mesh, int MeshType);
+
+// rh[d] = 1/spacing if axis d is uniform, else 0.
+void MeshUniform(int* N, Cell* mesh, double* rh);
 #endif
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Moments.hh"
+
+// Columns per block: the nb accumulator rows of a block stay in L1 while f streams through.
+#define MOM_CB 256
+
+// Deepest stack of the reproducible tree: one partial per bit of nleaf, plus the leaf being added
+#define MOM_DEPTH 34
+
+
+void MomentsInit(MomentBasis* M, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, int* NV, int effD, int repro){
+
+	M->Nv = NV[0]*NV[1]*NV[2];
+	M->nb = 1 + effD;
+	M->B = new double[M->nb*M->Nv];
+	M->work = NULL;
+	M->nwork = 0;
+	M->repro = repro;
+	M->nleaf = (M->Nv + MOM_VB - 1)/MOM_VB;
+
+	M->tree = new double[MomentsTreeSize(M)];
+
+	int Nv = M->Nv;
+
+	for(int vx = 0; vx < NV[0]; vx++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vz = 0; vz < NV[2]; vz++){
+
+				int v = vx + NV[0]*vy + NV[0]*NV[1]*vz;
+				double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+				double wv = Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
+
+				M->B[MOM_RHO*Nv + v] = wv;
+				for(int d = 0; d < effD; d++){M->B[(MOM_XI + d)*Nv + v] = wv*Xi[d];}
+			}
+		}
+	}
+}
+
+void MomentsFree(MomentBasis* M){
+
+	delete[] M->B;
+	delete[] M->work;
+	delete[] M->tree;
+	M->B = NULL;
+	M->work = NULL;
+	M->tree = NULL;
+	M->nwork = 0;
+}
+
+long MomentsTreeSize(const MomentBasis* M){
+
+	int depth = 1;
+	while((1L << (depth - 1)) < M->nleaf){depth++;}
+	return (long)(depth + 1)*M->nb*MOM_CB;
+}
+
+double* MomentsWork(MomentBasis* M, int n){
+
+	if(n > M->nwork){
+		delete[] M->work;
+		M->work = new double[n];
+		M->nwork = n;
+	}
+	return M->work;
+}
+
+// acc[r*lda + c] = sum_{v0 <= v < v1} B[r][v]*f[v*Ncols + c0 + c] for r < nr, c < nc.
+// Velocities go four at a time so every accumulator load/store is amortized over four multiply-adds.
+// The plain and the reproducible paths both sum through here, so a column's arithmetic does not
+// depend on the column block it falls in.
+static void MomentsBlock(const double* B, int Nv, const double* f, int Ncols, int c0, int nc, int nr, int v0, int v1, double* acc, long lda){
+
+	for(int r = 0; r < nr; r++){
+		for(int c = 0; c < nc; c++){acc[r*lda + c] = 0;}
+	}
+
+	int v = v0;
+	for(; v + 3 < v1; v += 4){
+		const double* f0 = f + (v+0)*(long)Ncols + c0;
+		const double* f1 = f + (v+1)*(long)Ncols + c0;
+		const double* f2 = f + (v+2)*(long)Ncols + c0;
+		const double* f3 = f + (v+3)*(long)Ncols + c0;
+
+		for(int r = 0; r < nr; r++){
+			double* a = acc + r*lda;
+			const double* b = B + r*Nv;
+			double b0 = b[v], b1 = b[v+1], b2 = b[v+2], b3 = b[v+3];
+
+			for(int c = 0; c < nc; c++){a[c] += b0*f0[c] + b1*f1[c] + b2*f2[c] + b3*f3[c];}
+		}
+	}
+	for(; v < v1; v++){
+		const double* f0 = f + v*(long)Ncols + c0;
+
+		for(int r = 0; r < nr; r++){
+			double* a = acc + r*lda;
+			double b0 = B[r*Nv + v];
+
+			for(int c = 0; c < nc; c++){a[c] += b0*f0[c];}
+		}
+	}
+}
+
+static inline void AddInto(double* a, const double* b, long n){
+	for(long i = 0; i < n; i++){a[i] = a[i] + b[i];}
+}
+
+// Skinny GEMM: out (nr x Ncols) = B[r0:r0+nr] (nr x Nv) * f (Nv x Ncols).
+// Each column block is accumulated over all velocities before moving on, so f is read once.
+// In reproducible mode the leaves of a column block are reduced as they are produced with a
+// binary counter: equal sized partials are merged as soon as both exist, and the partials left
+// at the end (one per set bit of nleaf) are merged from the smallest up. This is the tree
+// T(l, n) = T(l, h) + T(l + h, n - h), h the largest power of two below n, that MomentsTree builds.
+void Moments(const MomentBasis* M, const double* f, int Ncols, int r0, int nr, double* out){
+
+	MomentsCols(M, f, Ncols, 0, Ncols, r0, nr, out, M->tree);
+}
+
+void MomentsCols(const MomentBasis* M, const double* f, int Ncols, int cb, int ce, int r0, int nr, double* out, double* tree){
+
+	int Nv = M->Nv;
+	const double* B = M->B + r0*Nv;
+
+	for(int c0 = cb; c0 < ce; c0 += MOM_CB){
+
+		int nc = ce - c0 < MOM_CB ? ce - c0 : MOM_CB;
+
+		if(!M->repro){
+			MomentsBlock(B, Nv, f, Ncols, c0, nc, nr, 0, Nv, out + c0, Ncols);
+			continue;
+		}
+
+		long slot = (long)nr*MOM_CB;
+		int size[MOM_DEPTH];
+		int top = 0;
+		for(int l = 0; l < M->nleaf; l++){
+			int v1 = (l + 1)*MOM_VB < Nv ? (l + 1)*MOM_VB : Nv;
+			MomentsBlock(B, Nv, f, Ncols, c0, nc, nr, l*MOM_VB, v1, tree + top*slot, MOM_CB);
+			size[top++] = 1;
+			while(top >= 2 && size[top-1] == size[top-2]){
+				AddInto(tree + (top-2)*slot, tree + (top-1)*slot, slot);
+				size[top-2] *= 2;
+				top--;
+			}
+		}
+		while(top >= 2){
+			AddInto(tree + (top-2)*slot, tree + (top-1)*slot, slot);
+			top--;
+		}
+
+		for(int r = 0; r < nr; r++){
+			for(int c = 0; c < nc; c++){out[r*Ncols + c0 + c] = tree[r*MOM_CB + c];}
+		}
+	}
+}
+
+void MomentsLeaves(const MomentBasis* M, const double* f, int Ncols, int r0, int nr, int l0, int l1, double* leaves){
+
+	int Nv = M->Nv;
+	const double* B = M->B + r0*Nv;
+	long n = (long)nr*Ncols;
+
+	for(int l = l0; l < l1; l++){
+		int v1 = (l + 1)*MOM_VB < Nv ? (l + 1)*MOM_VB : Nv;
+		for(int c0 = 0; c0 < Ncols; c0 += MOM_CB){
+			int nc = Ncols - c0 < MOM_CB ? Ncols - c0 : MOM_CB;
+			MomentsBlock(B, Nv, f, Ncols, c0, nc, nr, l*MOM_VB, v1, leaves + (l - l0)*n + c0, Ncols);
+		}
+	}
+}
+
+void MomentsTree(const MomentBasis* M, double* leaves, long n, double* out){
+
+	int first[MOM_DEPTH];
+	int size[MOM_DEPTH];
+	int top = 0;
+	for(int l = 0; l < M->nleaf; l++){
+		first[top] = l;
+		size[top++] = 1;
+		while(top >= 2 && size[top-1] == size[top-2]){
+			AddInto(leaves + first[top-2]*n, leaves + first[top-1]*n, n);
+			size[top-2] *= 2;
+			top--;
+		}
+	}
+	while(top >= 2){
+		AddInto(leaves + first[top-2]*n, leaves + first[top-1]*n, n);
+		top--;
+	}
+
+	for(long i = 0; i < n; i++){out[i] = leaves[i];}
+}
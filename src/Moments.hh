@@ -0,0 +1,56 @@
+#ifndef MOMENTS_HH
+#define MOMENTS_HH
+
+// Velocity moments as dense matrix products.
+// Distributions are stored velocity-major, f[v*Ncols + c] with v = vx + NV[0]*vy + NV[0]*NV[1]*vz,
+// so a distribution is an Nv x Ncols matrix and its moments are the product B*f with the
+// (1+effD) x Nv basis B whose rows are w and w*Xi[d] (w = Co_WX*Co_WY*Co_WZ).
+// Ncols is Nc for cell centered arrays (g, b, Fg, Fb) and Nc*effD for interface arrays (gbar, bbar).
+
+#define MOM_RHO 0 // Basis row of w
+#define MOM_XI  1 // Basis row of w*Xi[0], w*Xi[d] is row MOM_XI + d
+
+// Reproducible mode: velocities are summed in leaves of MOM_VB consecutive velocities, and the
+// leaf sums are combined by a pairwise tree whose shape depends only on the number of leaves.
+// The result is then fixed by Nv alone, so a caller that splits the velocities across threads
+// or pieces on leaf boundaries (MomentsLeaves) and combines the leaves with MomentsTree gets
+// bitwise the same moments for any thread or piece count.
+#define MOM_VB 16
+
+struct MomentBasis{
+
+	int Nv;      // Velocities
+	int nb;      // Basis rows, 1 + effD
+	double* B;   // nb x Nv basis
+	int repro;   // Use the fixed pairwise tree over velocity leaves
+	int nleaf;   // Leaves of MOM_VB velocities, the last one may be short
+
+	double* work; // Scratch for callers that scatter moments into another layout
+	int nwork;
+
+	double* tree; // Partial sums of the reproducible tree
+};
+
+void MomentsInit(MomentBasis* M, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, int* NV, int effD, int repro);
+void MomentsFree(MomentBasis* M);
+
+// out[r*Ncols + c] = sum_v B[r0 + r][v]*f[v*Ncols + c] for r < nr, c < Ncols.
+// In reproducible mode the sum over v is taken in the MOM_VB leaf / pairwise tree order.
+void Moments(const MomentBasis* M, const double* f, int Ncols, int r0, int nr, double* out);
+
+// Columns cb <= c < ce of Moments, written to the same places in out, so callers working on disjoint column
+// ranges can share out. tree is scratch of MomentsTreeSize(M) doubles for the reproducible mode (one per
+// thread; Moments uses M->tree). A column's arithmetic is the same whatever range it is computed in.
+void MomentsCols(const MomentBasis* M, const double* f, int Ncols, int cb, int ce, int r0, int nr, double* out, double* tree);
+long MomentsTreeSize(const MomentBasis* M);
+
+// Sums over leaves l0 <= l < l1 only: leaves[((l-l0)*nr + r)*Ncols + c], each summed in velocity order.
+void MomentsLeaves(const MomentBasis* M, const double* f, int Ncols, int r0, int nr, int l0, int l1, double* leaves);
+
+// Combine all M->nleaf leaf sums (n = nr*Ncols values per leaf) with the fixed tree into out. leaves is overwritten.
+void MomentsTree(const MomentBasis* M, double* leaves, long n, double* out);
+
+// Scratch of at least n doubles, owned by M.
+double* MomentsWork(MomentBasis* M, int n);
+
+#endif
@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "OutOfCore.hh"
+
+//Map a new file of bytes under dir, unlinked so it goes away with the process
+static double* MapFile(const char* dir, const char* name, long bytes, int* fd){
+
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/cdugks_%s_XXXXXX", dir, name);
+	*fd = mkstemp(path);
+	if(*fd < 0){printf("Cannot create %s\n", path); return NULL;}
+	unlink(path);
+	if(ftruncate(*fd, bytes) != 0){printf("Cannot grow %s to %ld bytes\n", path, bytes); close(*fd); return NULL;}
+
+	void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+	if(p == MAP_FAILED){printf("Cannot map %s\n", path); close(*fd); return NULL;}
+	return (double*)p;
+}
+
+static void WindowAlloc(OOCWindow* W, long Lc, int Nv, int effD){
+
+	W->g = new double[Lc*Nv];
+	W->b = new double[Lc*Nv];
+	W->rho = new double[Lc];
+	W->rhov = new double[Lc*effD];
+	W->rhoE = new double[Lc];
+	W->mesh = new Cell[Lc];
+	W->a = new double[Lc*effD];
+}
+
+static void WindowFree(OOCWindow* W){
+
+	delete[] W->g;
+	delete[] W->b;
+	delete[] W->rho;
+	delete[] W->rhov;
+	delete[] W->rhoE;
+	delete[] W->mesh;
+	delete[] W->a;
+}
+
+static void IOJob(OutOfCore* O, int t);
+
+static void IOThread(OutOfCore* O){
+
+	while(1){
+		int t;
+		{
+			std::unique_lock<std::mutex> l(O->lock);
+			O->post.wait(l, [&]{return O->quit || O->job >= 0;});
+			if(O->quit){return;}
+			t = O->job;
+		}
+		IOJob(O, t);
+		{
+			std::lock_guard<std::mutex> l(O->lock);
+			O->job = -1;
+		}
+		O->finish.notify_one();
+	}
+}
+
+int OOCInit(OutOfCore* O, const char* dir, int width, int* N, int* NV, int effD, int* BCs){
+
+	O->effD = effD;
+	O->Nv = NV[0]*NV[1]*NV[2];
+	O->Nc = (long)N[0]*N[1]*N[2];
+	O->Ns = N[effD-1];
+	O->layer = O->Nc/O->Ns;
+	O->periodic = (BCs[effD-1] == 0);
+
+	//Slabs of about width rows, no narrower than the halo, windows small enough for int indices
+	if(width < STEP_REACH){width = STEP_REACH;}
+	while(width > STEP_REACH && (long)effD*effD*O->layer*(width + 2*STEP_REACH)*O->Nv > INT_MAX){width--;}
+	if((long)effD*effD*O->layer*(width + 2*STEP_REACH)*O->Nv > INT_MAX){printf("Rows of %d cells and %d velocities are too large for a window\n", O->layer, O->Nv); return 0;}
+	int n = (O->Ns + width - 1)/width;
+	if(n > O->Ns/STEP_REACH){n = O->Ns/STEP_REACH;}
+	if(n < 1){n = 1;}
+
+	O->n = n;
+	O->s0 = new int[n + 1];
+	for(int t = 0; t <= n; t++){O->s0[t] = (long)O->Ns*t/n;}
+	O->halo = (n > 1) ? STEP_REACH : 0;
+	O->L = (O->Ns + n - 1)/n + 2*O->halo;
+
+	O->bytes = O->Nc*O->Nv*(long)sizeof(double);
+	O->g = MapFile(dir, "g", O->bytes, &O->fd[0]);
+	if(O->g == NULL){return 0;}
+	O->b = MapFile(dir, "b", O->bytes, &O->fd[1]);
+	if(O->b == NULL){munmap(O->g, O->bytes); close(O->fd[0]); return 0;}
+
+	long Lc = (long)O->layer*O->L;
+	int Nv = O->Nv;
+	for(int k = 0; k < 2; k++){WindowAlloc(&O->win[k], Lc, Nv, effD);}
+
+	O->gbar = new double[Lc*Nv*effD];
+	O->bbar = new double[Lc*Nv*effD];
+	O->gbarp = new double[Lc*Nv];
+	O->bbarp = new double[Lc*Nv];
+	O->gsigma = new double[Lc*Nv*effD];
+	O->bsigma = new double[Lc*Nv*effD];
+	O->gsigma2 = new double[Lc*Nv*effD*effD];
+	O->bsigma2 = new double[Lc*Nv*effD*effD];
+	O->gbarpbound = new double[Lc*Nv*effD];
+	O->bbarpbound = new double[Lc*Nv*effD];
+	O->rhoh = new double[Lc*effD];
+	O->rhovh = new double[Lc*effD*effD];
+	O->rhoEh = new double[Lc*effD];
+	O->Q = new double[Lc](); // Step 3 leaves it zero without sources
+	O->T = new double[Lc];
+
+	long Hc = (long)O->layer*STEP_REACH;
+	O->wg = new double[Hc*Nv];
+	O->wb = new double[Hc*Nv];
+	O->wrho = new double[Hc];
+	O->wrhov = new double[Hc*effD];
+	O->wrhoE = new double[Hc];
+
+	O->job = -1;
+	O->quit = 0;
+	O->stall = 0;
+	O->io = std::thread(IOThread, O);
+	return 1;
+}
+
+void OOCFree(OutOfCore* O){
+
+	{
+		std::lock_guard<std::mutex> l(O->lock);
+		O->quit = 1;
+	}
+	O->post.notify_all();
+	O->io.join();
+
+	munmap(O->g, O->bytes);
+	munmap(O->b, O->bytes);
+	close(O->fd[0]);
+	close(O->fd[1]);
+
+	for(int k = 0; k < 2; k++){WindowFree(&O->win[k]);}
+	delete[] O->s0;
+	delete[] O->gbar;
+	delete[] O->bbar;
+	delete[] O->gbarp;
+	delete[] O->bbarp;
+	delete[] O->gsigma;
+	delete[] O->bsigma;
+	delete[] O->gsigma2;
+	delete[] O->bsigma2;
+	delete[] O->gbarpbound;
+	delete[] O->bbarpbound;
+	delete[] O->rhoh;
+	delete[] O->rhovh;
+	delete[] O->rhoEh;
+	delete[] O->Q;
+	delete[] O->T;
+	delete[] O->wg;
+	delete[] O->wb;
+	delete[] O->wrho;
+	delete[] O->wrhov;
+	delete[] O->wrhoE;
+}
+
+//Rows wl <= l < wl + nl of a window (planes of wplane values) to or from rows al of an array (planes of aplane
+//values), run values per row, in nv planes
+template <typename T> static void CopyRows(T* win, long wplane, int wl, T* arr, long aplane, long al, int nl, long run, int nv, int load){
+
+	for(int v = 0; v < nv; v++){
+		T* w = win + v*wplane + wl*run;
+		T* a = arr + v*aplane + al*run;
+		if(load){memcpy(w, a, nl*run*sizeof(T));}
+		else{memcpy(a, w, nl*run*sizeof(T));}
+	}
+}
+
+static void WindowRange(OutOfCore* O, int t, int* start, int* nl){
+
+	int a = O->s0[t] - O->halo;
+	int e = O->s0[t+1] + O->halo;
+	if(!O->periodic){
+		if(a < 0){a = 0;}
+		if(e > O->Ns){e = O->Ns;}
+	}
+	*start = a;
+	*nl = e - a;
+}
+
+static void LoadWindow(OutOfCore* O, OOCWindow* W, int t){
+
+	WindowRange(O, t, &W->start, &W->nl);
+	W->t = t;
+	W->lo = O->s0[t] - W->start;
+
+	int effD = O->effD;
+	int Nv = O->Nv;
+	long layer = O->layer;
+	long wplane = layer*W->nl;
+	long Hc = layer*STEP_REACH;
+
+	//Contiguous pieces of rows: wrapped from the end, in range, or wrapped onto the rows kept at the start of the step
+	for(int l = 0; l < W->nl;){
+		long u = W->start + l;
+		long gl;
+		int len;
+		int kept = 0;
+		if(u < 0){gl = u + O->Ns; len = -u;}
+		else if(u >= O->Ns){gl = u - O->Ns; len = W->nl - l; kept = 1;}
+		else{gl = u; len = O->Ns - u;}
+		if(len > W->nl - l){len = W->nl - l;}
+
+		if(kept){
+			CopyRows(W->g, wplane, l, O->wg, Hc, gl, len, layer, Nv, 1);
+			CopyRows(W->b, wplane, l, O->wb, Hc, gl, len, layer, Nv, 1);
+			CopyRows(W->rho, 0, l, O->wrho, 0, gl, len, layer, 1, 1);
+			CopyRows(W->rhov, 0, l, O->wrhov, 0, gl, len, effD*layer, 1, 1);
+			CopyRows(W->rhoE, 0, l, O->wrhoE, 0, gl, len, layer, 1, 1);
+		}
+		else{
+			CopyRows(W->g, wplane, l, O->g, O->Nc, gl, len, layer, Nv, 1);
+			CopyRows(W->b, wplane, l, O->b, O->Nc, gl, len, layer, Nv, 1);
+			CopyRows(W->rho, 0, l, O->rho, 0, gl, len, layer, 1, 1);
+			CopyRows(W->rhov, 0, l, O->rhov, 0, gl, len, effD*layer, 1, 1);
+			CopyRows(W->rhoE, 0, l, O->rhoE, 0, gl, len, layer, 1, 1);
+		}
+		CopyRows(W->mesh, 0, l, O->mesh, 0, gl, len, layer, 1, 1);
+		CopyRows(W->a, 0, l, O->S->a, 0, gl, len, effD*layer, 1, 1);
+		l += len;
+	}
+}
+
+static void StoreWindow(OutOfCore* O, OOCWindow* W){
+
+	int effD = O->effD;
+	long layer = O->layer;
+	long wplane = layer*W->nl;
+	int s0 = O->s0[W->t];
+	int len = O->s0[W->t+1] - s0;
+
+	CopyRows(W->g, wplane, W->lo, O->g, O->Nc, s0, len, layer, O->Nv, 0);
+	CopyRows(W->b, wplane, W->lo, O->b, O->Nc, s0, len, layer, O->Nv, 0);
+	CopyRows(W->rho, 0, W->lo, O->rho, 0, s0, len, layer, 1, 0);
+	CopyRows(W->rhov, 0, W->lo, O->rhov, 0, s0, len, effD*layer, 1, 0);
+	CopyRows(W->rhoE, 0, W->lo, O->rhoE, 0, s0, len, layer, 1, 0);
+}
+
+//Ask the kernel to read the rows of the window of slab t ahead of its load
+static void Prefetch(OutOfCore* O, int t){
+
+	int start, nl;
+	WindowRange(O, t, &start, &nl);
+	if(start < 0 || start + nl > O->Ns){return;} // Wrapping windows are small, let them fault
+	long page = sysconf(_SC_PAGESIZE);
+	long len = (long)O->layer*nl*sizeof(double);
+
+	for(int v = 0; v < O->Nv; v++){
+		long off = ((long)v*O->Nc + (long)O->layer*start)*sizeof(double);
+		long a = off - off%page;
+		madvise((char*)O->g + a, len + off - a, MADV_WILLNEED);
+		madvise((char*)O->b + a, len + off - a, MADV_WILLNEED);
+	}
+}
+
+//Runs while slab t is computed: write back slab t-1, load slab t+1 and read ahead slab t+2
+static void IOJob(OutOfCore* O, int t){
+
+	if(t >= 1){StoreWindow(O, &O->win[(t-1)%2]);}
+	if(t + 1 < O->n){LoadWindow(O, &O->win[(t+1)%2], t + 1);}
+	if(t + 2 < O->n){Prefetch(O, t + 2);}
+}
+
+static void Post(OutOfCore* O, int t){
+
+	{
+		std::lock_guard<std::mutex> l(O->lock);
+		O->job = t;
+	}
+	O->post.notify_one();
+}
+
+static void Wait(OutOfCore* O){
+
+	auto t0 = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> l(O->lock);
+	O->finish.wait(l, [&]{return O->job < 0;});
+	O->stall += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//The step of Evolve on a window, as a domain of W->nl rows
+static void StepWindow(OutOfCore* O, OOCWindow* W, double h, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+
+	int Nw[3] = {N[0], N[1], N[2]};
+	Nw[effD-1] = W->nl;
+	int s1 = W->nl;
+	int Nc = Nw[0]*Nw[1]*Nw[2];
+	double* work = MomentsWork(M, (1+effD)*Nc*effD + (2+effD)*Nc);
+	double* Fm = work + (1+effD)*Nc*effD;
+
+	Source Sw = *O->S;
+	Sw.a = W->a;
+	Sw.Q = O->Q;
+	Sw.T = O->T;
+
+	Step3(&Sw, W->rho, W->rhov, W->rhoE, Nw, effD, 0, s1);
+
+	SK->Step1a(W->g, W->b, O->gbar, O->bbar, O->gbarp, O->bbarp, &Sw, W->rho, W->rhov, W->rhoE, h, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, s1);
+	SK->Step1b(O->gbarp, O->bbarp, O->gsigma, O->bsigma, O->gsigma2, O->bsigma2, W->mesh, SK->rh, O->gbarpbound, O->bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, 2, 0, s1);
+	SK->Step1c(O->gbar, O->bbar, O->gbarpbound, O->bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, O->gsigma2, O->bsigma2, h, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, s1);
+
+	Step2a(O->gbar, O->bbar, M, &Sw, h, O->rhoh, O->rhovh, O->rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, effD, 0, s1, work, M->tree);
+	SK->Step2b(O->gbar, O->bbar, &Sw, h, O->rhoh, O->rhovh, O->rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, s1);
+	SK->Step2c(O->gbar, O->bbar, Co_X, Co_Y, Co_Z, W->mesh, O->gbarp, O->bbarp, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, s1);
+
+	SK->Step4and5(W->rho, W->rhov, W->rhoE, h, W->mesh, O->gbarp, O->bbarp, Co_X, Co_Y, Co_Z, M, &Sw, W->g, W->b, R, K, Cv, gma, w, ur, Tr, Pr, Nw, NV, 0, s1, Fm, M->tree);
+}
+
+int EvolveOutOfCore(OutOfCore* O, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, Cell* mesh, double* Tdump, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
+
+	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
+
+	int dump = (*dt < calcdt);
+
+	O->rho = rho;
+	O->rhov = rhov;
+	O->rhoE = rhoE;
+	O->mesh = mesh;
+	O->S = S;
+
+	//Old state of the rows the last window wraps onto
+	if(O->periodic && O->n > 1){
+		long Hc = (long)O->layer*STEP_REACH;
+		CopyRows(O->wg, Hc, 0, O->g, O->Nc, 0, STEP_REACH, O->layer, O->Nv, 1);
+		CopyRows(O->wb, Hc, 0, O->b, O->Nc, 0, STEP_REACH, O->layer, O->Nv, 1);
+		CopyRows(O->wrho, 0, 0, rho, 0, 0, STEP_REACH, O->layer, 1, 1);
+		CopyRows(O->wrhov, 0, 0, rhov, 0, 0, STEP_REACH, effD*O->layer, 1, 1);
+		CopyRows(O->wrhoE, 0, 0, rhoE, 0, 0, STEP_REACH, O->layer, 1, 1);
+	}
+
+	LoadWindow(O, &O->win[0], 0);
+	for(int t = 0; t < O->n; t++){
+		Post(O, t);
+		StepWindow(O, &O->win[t%2], *dt, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, M, SK, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
+		Wait(O);
+	}
+	StoreWindow(O, &O->win[(O->n-1)%2]);
+
+	return dump;
+}
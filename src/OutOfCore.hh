@@ -0,0 +1,112 @@
+#ifndef OUTOFCORE_HH
+#define OUTOFCORE_HH
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Evolution.hh"
+
+// Out-of-core step (-u dir). g and b live in files under dir, mapped into memory, and the other phase space
+// arrays of the step are never allocated for the whole domain. The last active axis is cut into slabs of about
+// -w rows. A slab is loaded with STEP_REACH rows of halo on each side (the window), the step kernels run on the
+// window as if it were the domain, and the interior rows are written back: the rows a halo's edge corrupts are
+// within STEP_REACH of it, so the interior is bitwise the step Evolve takes.
+// Slabs go in order and the state is updated in place. While slab t is computed an I/O thread writes slab t-1
+// back and loads the window of slab t+1, which only overlaps slab t (still old) as slabs are at least STEP_REACH
+// rows wide, and asks the kernel to read ahead the window of slab t+2. On a periodic axis the last window wraps
+// onto the first rows, which are written back by then, so their old state is kept at the start of the step.
+// The files are unlinked once mapped, so they go away with the process.
+// A window's arrays are indexed with int like the kernels', which bounds the slab width (effD^2 interface
+// slopes per velocity and cell must stay below 2^31).
+
+struct OOCWindow{
+
+	int t;        // Slab
+	int start;    // First row, unwrapped (negative or past the end when the window wraps)
+	int nl;       // Rows
+	int lo;       // Row of the window where the slab starts
+
+	// State, planes of layer*nl cells
+	double* g;
+	double* b;
+	double* rho;
+	double* rhov;
+	double* rhoE;
+	Cell* mesh;
+	double* a;    // Acceleration of the sources
+};
+
+struct OutOfCore{
+
+	int n;        // Slabs
+	int* s0;      // Slab t is s0[t] <= s < s0[t+1] along the last active axis
+	int halo;     // STEP_REACH, 0 for a single slab
+	int Ns;       // Rows
+	int layer;    // Cells per row
+	int L;        // Rows of the largest window
+	int periodic;
+	int effD;
+	int Nv;
+	long Nc;
+
+	// Mapped files
+	int fd[2];
+	double* g;
+	double* b;
+	long bytes;   // Of each file
+
+	OOCWindow win[2]; // Slabs t and t+1
+
+	// Step scratch of one window
+	double* gbar;
+	double* bbar;
+	double* gbarp;
+	double* bbarp;
+	double* gsigma;
+	double* bsigma;
+	double* gsigma2;
+	double* bsigma2;
+	double* gbarpbound;
+	double* bbarpbound;
+	double* rhoh;
+	double* rhovh;
+	double* rhoEh;
+	double* Q;
+	double* T;
+
+	// Rows 0 <= s < halo at the start of the step, for the window that wraps onto them
+	double* wg;
+	double* wb;
+	double* wrho;
+	double* wrhov;
+	double* wrhoE;
+
+	// Arrays of the whole domain the I/O thread copies from and to, set by each step
+	double* rho;
+	double* rhov;
+	double* rhoE;
+	Cell* mesh;
+	Source* S;
+
+	// I/O thread, runs the job of slab job (-1 for none)
+	std::thread io;
+	std::mutex lock;
+	std::condition_variable post;
+	std::condition_variable finish;
+	int job;
+	int quit;
+	double stall; // Seconds the step waited for the I/O thread
+};
+
+// width is the rows per slab, clamped to [STEP_REACH, N[effD-1]]. Returns 0 if the files cannot be made.
+int OOCInit(OutOfCore* O, const char* dir, int width, int* N, int* NV, int effD, int* BCs);
+void OOCFree(OutOfCore* O);
+
+// Same contract as Evolve, with g and b in O->g and O->b.
+int EvolveOutOfCore(OutOfCore* O, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, Cell* mesh, double* Tdump, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
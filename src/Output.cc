@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Output.hh"
+
+static int InRange(int* lo, int* hi, int* N){
+
+	for(int d = 0; d < 3; d++){
+		if(lo[d] < 0 || hi[d] >= N[d] || lo[d] > hi[d]){return 0;}
+	}
+	return 1;
+}
+
+static void BoxIndices(OutputBox* B, int* N){
+
+	int n[3];
+	for(int d = 0; d < 3; d++){n[d] = (B->hi[d] - B->lo[d])/B->stride[d] + 1;}
+	B->n = n[0]*n[1]*n[2];
+	B->sidx = new int[B->n];
+
+	int m = 0;
+	for(int k = B->lo[2]; k <= B->hi[2]; k += B->stride[2]){
+		for(int j = B->lo[1]; j <= B->hi[1]; j += B->stride[1]){
+			for(int i = B->lo[0]; i <= B->hi[0]; i += B->stride[0]){
+				B->sidx[m++] = i + N[0]*j + N[0]*N[1]*k;
+			}
+		}
+	}
+}
+
+void OutputInit(Output* O){
+
+	O->nbox = 0;
+	O->nprobe = 0;
+	O->nring = 0;
+	O->ring_iter = NULL;
+	O->ring_T = NULL;
+	O->ring = NULL;
+}
+
+int OutputLoad(Output* O, const char* file, int* N){
+
+	OutputInit(O);
+
+	FILE* fp = fopen(file, "r");
+	if(fp == NULL){printf("Could not open output selection %s\n", file); return 0;}
+
+	char line[256];
+	int lineno = 0;
+	int ok = 1;
+	while(ok && fgets(line, sizeof(line), fp) != NULL){
+		lineno++;
+		char kind[16];
+		char name[OUT_NAME];
+		if(line[0] == '#' || sscanf(line, "%15s", kind) != 1){continue;}
+
+		if(strcmp(kind, "box") == 0 || strcmp(kind, "slice") == 0){
+			if(O->nbox == OUT_MAXSEL){printf("%s: more than %d boxes and slices\n", file, OUT_MAXSEL); ok = 0; break;}
+			OutputBox* B = &O->box[O->nbox];
+
+			int read;
+			if(kind[0] == 'b'){
+				read = sscanf(line, "%*s %31s %d %d %d %d %d %d %d %d %d %d", name, &B->every,
+				              &B->lo[0], &B->hi[0], &B->stride[0], &B->lo[1], &B->hi[1], &B->stride[1], &B->lo[2], &B->hi[2], &B->stride[2]) == 11;
+			}
+			else{
+				int axis, index;
+				read = sscanf(line, "%*s %31s %d %d %d", name, &B->every, &axis, &index) == 4 && axis >= 0 && axis < 3;
+				for(int d = 0; read && d < 3; d++){
+					B->lo[d] = (d == axis) ? index : 0;
+					B->hi[d] = (d == axis) ? index : N[d] - 1;
+					B->stride[d] = 1;
+				}
+			}
+			if(!read || B->every < 1 || B->stride[0] < 1 || B->stride[1] < 1 || B->stride[2] < 1 || !InRange(B->lo, B->hi, N)){
+				printf("%s:%d: bad %s for N = {%d, %d, %d}\n", file, lineno, kind, N[0], N[1], N[2]); ok = 0; break;
+			}
+
+			strcpy(B->name, name);
+			B->last = 0;
+			B->ndump = 0;
+			BoxIndices(B, N);
+			O->nbox++;
+		}
+		else if(strcmp(kind, "probe") == 0){
+			if(O->nprobe == OUT_MAXSEL){printf("%s: more than %d probes\n", file, OUT_MAXSEL); ok = 0; break;}
+			int p[3];
+			if(sscanf(line, "%*s %31s %d %d %d", name, &p[0], &p[1], &p[2]) != 4 || !InRange(p, p, N)){
+				printf("%s:%d: bad probe for N = {%d, %d, %d}\n", file, lineno, N[0], N[1], N[2]); ok = 0; break;
+			}
+			strcpy(O->probe[O->nprobe], name);
+			O->psidx[O->nprobe] = p[0] + N[0]*p[1] + N[0]*N[1]*p[2];
+			O->nprobe++;
+		}
+		else{
+			printf("%s:%d: unknown entry %s\n", file, lineno, kind); ok = 0;
+		}
+	}
+	fclose(fp);
+	if(!ok){OutputFree(O); return 0;}
+
+	if(O->nprobe > 0){
+		O->ring_iter = new int[OUT_RING];
+		O->ring_T = new double[OUT_RING];
+		O->ring = new double[OUT_RING*O->nprobe*OUT_NVAR];
+	}
+	for(int p = 0; p < O->nprobe; p++){
+		char path[64 + OUT_NAME];
+		sprintf(path, "Data/probe_%s.txt", O->probe[p]);
+		FILE* fp = fopen(path, "w");
+		if(fp == NULL){printf("Could not create %s\n", path); OutputFree(O); return 0;}
+		fprintf(fp, "# iter Tsim rho rhovx rhovy rhovz rhoE\n");
+		fclose(fp);
+	}
+
+	printf("Output selection %s: %d boxes and slices, %d probes\n", file, O->nbox, O->nprobe);
+	return 1;
+}
+
+void OutputFree(Output* O){
+
+	for(int n = 0; n < O->nbox; n++){delete[] O->box[n].sidx;}
+	delete[] O->ring_iter;
+	delete[] O->ring_T;
+	delete[] O->ring;
+	OutputInit(O);
+}
+
+static inline void Gather(double* out, int sidx, double* rho, double* rhov, double* rhoE, int effD){
+
+	out[0] = rho[sidx];
+	for(int d = 0; d < 3; d++){out[1 + d] = (d < effD) ? rhov[effD*sidx + d] : 0;}
+	out[4] = rhoE[sidx];
+}
+
+static void WriteBox(OutputBox* B, double* rho, double* rhov, double* rhoE, int iter, double Tsim, int effD){
+
+	//Gather the selected cells first so the text formatting runs over one contiguous buffer
+	double* buf = new double[B->n*OUT_NVAR];
+	for(int m = 0; m < B->n; m++){Gather(buf + m*OUT_NVAR, B->sidx[m], rho, rhov, rhoE, effD);}
+
+	char path[64 + OUT_NAME];
+	sprintf(path, "Data/%s%04d.txt", B->name, B->ndump);
+	FILE* fp = fopen(path, "w");
+	if(fp == NULL){printf("Could not create %s\n", path); delete[] buf; return;}
+
+	fprintf(fp, "# iter = %d, Tsim = %e\n", iter, Tsim);
+	int m = 0;
+	for(int k = B->lo[2]; k <= B->hi[2]; k += B->stride[2]){
+		for(int j = B->lo[1]; j <= B->hi[1]; j += B->stride[1]){
+			for(int i = B->lo[0]; i <= B->hi[0]; i += B->stride[0]){
+				double* v = buf + (m++)*OUT_NVAR;
+				fprintf(fp, "%d %d %d %e %e %e %e %e\n", i, j, k, v[0], v[1], v[2], v[3], v[4]);
+			}
+		}
+	}
+	fclose(fp);
+	delete[] buf;
+
+	B->ndump++;
+}
+
+void OutputStep(Output* O, double* rho, double* rhov, double* rhoE, int iter, double Tsim, int effD){
+
+	if(O->nprobe > 0){
+		int r = O->nring;
+		O->ring_iter[r] = iter;
+		O->ring_T[r] = Tsim;
+		for(int p = 0; p < O->nprobe; p++){Gather(O->ring + (r*O->nprobe + p)*OUT_NVAR, O->psidx[p], rho, rhov, rhoE, effD);}
+		O->nring++;
+		if(O->nring == OUT_RING){OutputFlush(O);}
+	}
+
+	for(int n = 0; n < O->nbox; n++){
+		OutputBox* B = &O->box[n];
+		if(iter == 0 || iter - B->last >= B->every){
+			B->last = iter;
+			WriteBox(B, rho, rhov, rhoE, iter, Tsim, effD);
+		}
+	}
+}
+
+void OutputFlush(Output* O){
+
+	for(int p = 0; p < O->nprobe && O->nring > 0; p++){
+		char path[64 + OUT_NAME];
+		sprintf(path, "Data/probe_%s.txt", O->probe[p]);
+		FILE* fp = fopen(path, "a");
+		if(fp == NULL){printf("Could not append to %s\n", path); continue;}
+		for(int r = 0; r < O->nring; r++){
+			double* v = O->ring + (r*O->nprobe + p)*OUT_NVAR;
+			fprintf(fp, "%d %.10e %.10e %.10e %.10e %.10e %.10e\n", O->ring_iter[r], O->ring_T[r], v[0], v[1], v[2], v[3], v[4]);
+		}
+		fclose(fp);
+	}
+	O->nring = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef OUTPUT_HH
+#define OUTPUT_HH
+
+// Output selection (-s file): boxes, slices and probes written in place of, or alongside, the full dumps.
+// One entry per line, # starts a comment, cell indices are 0-based and ranges inclusive:
+//   box   <name> <every> i0 i1 di j0 j1 dj k0 k1 dk   cells i0, i0+di, ... <= i1 (etc.) every <every> steps
+//   slice <name> <every> <axis> <index>               the plane (line in 2D) axis = index, every cell
+//   probe <name> i j k                                cell (i, j, k) every step
+// Boxes go to Data/<name>NNNN.txt, columns i j k rho rhovx rhovy rhovz rhoE after a # iter Tsim line.
+// Probes are kept in a ring of OUT_RING steps in memory and appended to Data/probe_<name>.txt,
+// columns iter Tsim rho rhovx rhovy rhovz rhoE, whenever it fills and at the end of the run.
+
+#define OUT_MAXSEL 32  // Boxes and slices, and separately probes
+#define OUT_NAME   32
+#define OUT_RING   256 // Steps of probe records held before a flush
+#define OUT_NVAR   5   // rho, rhov[3], rhoE
+
+struct OutputBox{
+
+	char name[OUT_NAME];
+	int every;       // Steps between writes
+	int last;        // Step of the last write
+	int ndump;
+	int lo[3];
+	int hi[3];
+	int stride[3];
+	int n;           // Selected cells
+	int* sidx;       // Their spatial indices, gathered in i fastest order
+};
+
+struct Output{
+
+	int nbox;
+	OutputBox box[OUT_MAXSEL];
+
+	int nprobe;
+	char probe[OUT_MAXSEL][OUT_NAME];
+	int psidx[OUT_MAXSEL];
+
+	int nring;       // Records in the ring
+	int* ring_iter;
+	double* ring_T;
+	double* ring;    // ring[(r*nprobe + p)*OUT_NVAR + var]
+};
+
+// Empty selection, nothing is written.
+void OutputInit(Output* O);
+// Parse the selection file and truncate the probe files. Returns 0 on failure.
+int OutputLoad(Output* O, const char* file, int* N);
+void OutputFree(Output* O);
+
+// After each step (after each block when blocking): record the probes and write the boxes that are due.
+void OutputStep(Output* O, double* rho, double* rhov, double* rhoE, int iter, double Tsim, int effD);
+// Append the probe records to their files and empty the ring.
+void OutputFlush(Output* O);
+
+#endif
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Source.hh"
+
+
+void SourceInit(Source* S, int* N, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+
+	S->on = 0;
+	S->a = new double[Nc*effD];
+	S->Q = new double[Nc];
+	S->T = new double[Nc];
+	for(int i = 0; i < Nc*effD; i++){S->a[i] = 0;}
+	for(int i = 0; i < Nc; i++){S->Q[i] = 0;}
+
+	S->Gamma = 0;
+	S->cooling = 0;
+	S->logT0 = 0;
+	S->dlogT = 1;
+	S->logL = new double[COOL_NTAB];
+}
+
+void SourceFree(Source* S){
+
+	delete[] S->a;
+	delete[] S->Q;
+	delete[] S->T;
+	delete[] S->logL;
+}
+
+void SourceConstantGravity(Source* S, double* g0, int* N, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+
+	for(int sidx = 0; sidx < Nc; sidx++){
+		for(int d = 0; d < effD; d++){S->a[effD*sidx + d] += g0[d]; if(g0[d] != 0){S->on = 1;}}
+	}
+}
+
+void SourcePotentialGravity(Source* S, const double* phi, Cell* mesh, int* N, int* BCs, int effD){
+
+	int Nx = N[0];
+	int Ny = N[1];
+
+	for(int i = 0; i < N[0]; i++){
+		for(int j = 0; j < N[1]; j++){
+			for(int k = 0; k < N[2]; k++){
+
+				int sidx = i + Nx*j + Nx*Ny*k;
+				int pos[3] = {i, j, k};
+
+				for(int d = 0; d < effD; d++){
+					int L[3] = {i, j, k};
+					int R[3] = {i, j, k};
+					L[d] = pos[d] - 1;
+					R[d] = pos[d] + 1;
+
+					//Periodic wraps, otherwise one sided at the boundary
+					if(BCs[d] == 0){L[d] = (L[d] + N[d])%N[d]; R[d] = R[d]%N[d];}
+					else{if(L[d] < 0){L[d] = 0;} if(R[d] == N[d]){R[d] = N[d] - 1;}}
+
+					int sL = L[0] + Nx*L[1] + Nx*Ny*L[2];
+					int sR = R[0] + Nx*R[1] + Nx*Ny*R[2];
+					double h[3] = {mesh[sidx].dx, mesh[sidx].dy, mesh[sidx].dz};
+
+					int span = (BCs[d] == 0) ? 2 : R[d] - L[d]; // Cells between the two samples
+
+					S->a[effD*sidx + d] += -(phi[sR] - phi[sL])/(span*h[d]);
+				}
+			}
+		}
+	}
+	S->on = 1;
+}
+
+void SourceHeating(Source* S, double Gamma){
+
+	S->Gamma = Gamma;
+	if(Gamma != 0){S->on = 1;}
+}
+
+int SourceLoadCooling(Source* S, const char* file){
+
+	FILE* fp = fopen(file, "r");
+	if(fp == NULL){printf("Could not open cooling curve %s\n", file); return 0;}
+
+	int n = 0;
+	int cap = 64;
+	double* lT = new double[cap];
+	double* lL = new double[cap];
+	char line[256];
+	while(fgets(line, sizeof(line), fp) != NULL){
+		double T, L;
+		if(line[0] == '#' || sscanf(line, "%lf %lf", &T, &L) != 2){continue;}
+		if(T <= 0){continue;}
+		if(n == cap){
+			double* t1 = new double[2*cap];
+			double* t2 = new double[2*cap];
+			for(int m = 0; m < n; m++){t1[m] = lT[m]; t2[m] = lL[m];}
+			delete[] lT; delete[] lL;
+			lT = t1; lL = t2; cap *= 2;
+		}
+		lT[n] = log10(T);
+		lL[n] = log10(fmax(L, 1e-300));
+		if(n > 0 && !(lT[n] > lT[n-1])){
+			printf("Cooling curve %s: T must increase strictly, %e follows %e\n", file, T, pow(10, lT[n-1]));
+			fclose(fp); delete[] lT; delete[] lL; return 0;
+		}
+		n++;
+	}
+	fclose(fp);
+
+	if(n < 2){printf("Cooling curve %s needs at least two points\n", file); delete[] lT; delete[] lL; return 0;}
+
+	//Resample log-log linearly onto the log-spaced table
+	S->logT0 = lT[0];
+	S->dlogT = (lT[n-1] - lT[0])/(COOL_NTAB - 1);
+	int m = 0;
+	for(int i = 0; i < COOL_NTAB; i++){
+		double x = S->logT0 + i*S->dlogT;
+		while(m < n - 2 && lT[m+1] < x){m++;}
+		double f = (x - lT[m])/(lT[m+1] - lT[m]);
+		f = fmin(fmax(f, 0.0), 1.0);
+		S->logL[i] = lL[m] + f*(lL[m+1] - lL[m]);
+	}
+
+	printf("Loaded cooling curve %s: %d points, T = %e to %e\n", file, n, pow(10, lT[0]), pow(10, lT[n-1]));
+	delete[] lT;
+	delete[] lL;
+
+	S->cooling = 1;
+	S->on = 1;
+	return 1;
+}
+
+//Branch free table lookup so the loop vectorizes: clamp the table coordinate, interpolate, mask below the table.
+void SourceRate(Source* S, double* rho, double* T, double* Q, int ncells){
+
+	if(S->cooling == 0){
+		for(int c = 0; c < ncells; c++){Q[c] = rho[c]*S->Gamma;}
+		return;
+	}
+
+	double inv = 1.0/S->dlogT;
+	double xmax = COOL_NTAB - 1.000001;
+	const double* tab = S->logL;
+
+	for(int c = 0; c < ncells; c++){
+		double x = (log10(T[c]) - S->logT0)*inv;
+		double on = (x >= 0) ? 1.0 : 0.0;
+		x = fmin(fmax(x, 0.0), xmax);
+		int i = (int)x;
+		double f = x - i;
+		double Lambda = on*exp2(3.321928094887362*(tab[i] + f*(tab[i+1] - tab[i]))); // 10^logL
+		Q[c] = rho[c]*S->Gamma - rho[c]*rho[c]*Lambda;
+	}
+}
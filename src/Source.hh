@@ -0,0 +1,61 @@
+#ifndef SOURCE_HH
+#define SOURCE_HH
+
+#include "Mesh.hh"
+
+// Source terms: gravity (constant or from a static potential), constant heating per unit mass
+// and radiative cooling from a tabulated cooling curve.
+// Step3 evaluates them once per cell per step from W at the start of the step: the acceleration a
+// (static) and the net heating rate per unit volume Q = rho*Gamma - rho^2*Lambda(T).
+// The per velocity sources are then built from the local equilibrium in the kernels,
+//   Sg = g_eq*(Xi - u).a/(R*T),  Sb = g_eq*(Xi.a + Q/rho),
+// whose moments are (0, rho*a) and rho*u.a + Q.
+
+#define COOL_NTAB 512 // Entries of the log-spaced cooling table
+
+struct Source{
+
+	int on;          // Any source term active
+	double* a;       // Acceleration, a[effD*sidx + d]
+	double* Q;       // Net heating rate per unit volume
+	double* T;       // Temperature, scratch for Step3
+
+	double Gamma;    // Heating per unit mass
+
+	// Cooling curve: log10(Lambda) at log10(T) = logT0 + i*dlogT, i < COOL_NTAB. No cooling below 10^logT0.
+	int cooling;
+	double logT0;
+	double dlogT;
+	double* logL;
+};
+
+void SourceInit(Source* S, int* N, int effD);
+void SourceFree(Source* S);
+
+// Constant acceleration g0[d] in every cell, added to a.
+void SourceConstantGravity(Source* S, double* g0, int* N, int effD);
+// -grad(phi) by centered differences, one sided at non-periodic boundaries, added to a. phi given per cell (-f files).
+void SourcePotentialGravity(Source* S, const double* phi, Cell* mesh, int* N, int* BCs, int effD);
+void SourceHeating(Source* S, double Gamma);
+// Two columns, T and Lambda(T), T strictly increasing; lines starting with # are skipped. Returns 0 on failure
+// (including a T column that does not increase, which the resampling relies on).
+int SourceLoadCooling(Source* S, const char* file);
+
+// Net heating rate per unit volume of ncells cells from their density and temperature.
+void SourceRate(Source* S, double* rho, double* T, double* Q, int ncells);
+
+// Per velocity sources Sg, Sb at velocity Xi of a cell with acceleration a[effD], net heating Q,
+// from its equilibrium g_eq and its rho, u, T.
+static inline void SourceVelocity(int effD, const double* a, double Q, double* Xi, double* u, double rho, double T, double R, double g_eq, double* Sg, double* Sb){
+
+	double ca = 0; // (Xi - u).a
+	double xa = 0; // Xi.a
+	for(int d = 0; d < effD; d++){
+		ca += (Xi[d] - u[d])*a[d];
+		xa += Xi[d]*a[d];
+	}
+	*Sg = g_eq*ca/(R*T);
+	*Sb = g_eq*(xa + Q/rho);
+}
+
+#endif
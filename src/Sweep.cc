@@ -0,0 +1,398 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Sweep.hh"
+
+//Neighbors of p along an axis of n cells: wrapped when periodic, clamped at Dirichlet and Neumann boundaries (as Step 1b)
+template <int BC> static inline void Neighbors(int p, int n, int* pL, int* pR){
+
+	if(BC == 0){*pL = (p - 1 + n)%n; *pR = (p + 1)%n;}
+	else{*pL = (p > 0) ? p - 1 : 0; *pR = (p < n - 1) ? p + 1 : n - 1;}
+}
+
+static inline double Position(const Cell& c, int ax){return ax == 0 ? c.x : (ax == 1 ? c.y : c.z);}
+static inline double Width(const Cell& c, int ax){return ax == 0 ? c.dx : (ax == 1 ? c.dy : c.dz);}
+static inline double Area(const Cell& c, int ax){return ax == 0 ? c.dy*c.dz : (ax == 1 ? c.dx*c.dz : c.dx*c.dy);}
+
+//One sweep along AX: Steps 1b to 4/5 of Evolution.cc restricted to the interfaces normal to AX.
+//Step 1a (gbarp, bbarp) is done by the caller with the sweep's dt. dts is the transport time of the sweep,
+//dtc the collision and source time of the cell update.
+template <int D, int AX, int BC, int LIM> static void SweepK(Sweep* W, double* g, double* b, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double dts, double dtc, Cell* mesh, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, double R, double K, double Pr, int* N, int* NVin){
+	constexpr int effD = D;
+	const int NV[3] = {NVin[0], D > 1 ? NVin[1] : 1, D > 2 ? NVin[2] : 1}; // Velocity axes beyond effD have one point
+
+	int Nx = N[0];
+	int Ny = N[1];
+	int Nz = N[2];
+	int Nc = Nx*Ny*Nz;
+	int n = N[AX];
+	int st = (AX == 0) ? 1 : ((AX == 1) ? Nx : Nx*Ny); // Stride of the axis in sidx
+	double* Co[3] = {Co_X, Co_Y, Co_Z};
+	double rh = W->rh[AX];
+
+	double* gsigma = W->gsigma;
+	double* bsigma = W->bsigma;
+	double* gsigma2 = W->gsigma2;
+	double* bsigma2 = W->bsigma2;
+	double* gbar = W->gbar;
+	double* bbar = W->bbar;
+
+	//Step 1b, pass 0: slopes of phibar along the axis.
+	//Velocity outermost, so every pass streams through contiguous rows of cells.
+	for(int vz = 0; vz < NV[2]; vz++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vx = 0; vx < NV[0]; vx++){
+				long o = (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+				for(int k = 0; k < Nz; k++){
+					for(int j = 0; j < Ny; j++){
+						for(int i = 0; i < Nx; i++){
+							int sidx = i + Nx*j + Nx*Ny*k;
+							int p = (AX == 0) ? i : ((AX == 1) ? j : k);
+							int pL, pR;
+							Neighbors<BC>(p, n, &pL, &pR);
+							int sL = sidx + (pL - p)*st;
+							int sR = sidx + (pR - p)*st;
+
+							double xL = Position(mesh[sL], AX);
+							double xC = Position(mesh[sidx], AX);
+							double xR = Position(mesh[sR], AX);
+
+							gsigma[o + sidx] = LimitedSlope<LIM>(gbarp[o + sL], gbarp[o + sidx], gbarp[o + sR], xL, xC, xR, rh);
+							bsigma[o + sidx] = LimitedSlope<LIM>(bbarp[o + sL], bbarp[o + sidx], bbarp[o + sR], xL, xC, xR, rh);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Step 1b, pass 1: slopes at the interface and the upwind interface values
+	for(int vz = 0; vz < NV[2]; vz++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vx = 0; vx < NV[0]; vx++){
+				long o = (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+				int v[3] = {vx, vy, vz};
+				int up = (Co[AX][v[AX]] < 0); // Upwind cell is the right neighbor
+				for(int k = 0; k < Nz; k++){
+					for(int j = 0; j < Ny; j++){
+						for(int i = 0; i < Nx; i++){
+							int sidx = i + Nx*j + Nx*Ny*k;
+							int p = (AX == 0) ? i : ((AX == 1) ? j : k);
+							int pL, pR;
+							Neighbors<BC>(p, n, &pL, &pR);
+							int sL = sidx + (pL - p)*st;
+							int sR = sidx + (pR - p)*st;
+
+							double xL = Position(mesh[sL], AX);
+							double xC = Position(mesh[sidx], AX);
+							double xR = Position(mesh[sR], AX);
+							double sC = Width(mesh[sidx], AX);
+
+							gsigma2[o + sidx] = gsigma[o + sidx] + (sC/2)*LimitedSlope<LIM>(gsigma[o + sL], gsigma[o + sidx], gsigma[o + sR], xL, xC, xR, rh);
+							bsigma2[o + sidx] = bsigma[o + sidx] + (sC/2)*LimitedSlope<LIM>(bsigma[o + sL], bsigma[o + sidx], bsigma[o + sR], xL, xC, xR, rh);
+
+							int interp = up ? sR : sidx;
+							double swap = up ? -1. : 1.;
+							gbar[o + sidx] = gbarp[o + interp] + swap*sC/2*gsigma[o + interp];
+							bbar[o + sidx] = bbarp[o + interp] + swap*sC/2*bsigma[o + interp];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Step 1c: phibar at the interface at t + dts/2
+	for(int vz = 0; vz < NV[2]; vz++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vx = 0; vx < NV[0]; vx++){
+				long o = (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+				int v[3] = {vx, vy, vz};
+				double Xi = Co[AX][v[AX]];
+				int up = (Xi < 0);
+				for(int k = 0; k < Nz; k++){
+					for(int j = 0; j < Ny; j++){
+						for(int i = 0; i < Nx; i++){
+							int sidx = i + Nx*j + Nx*Ny*k;
+							int p = (AX == 0) ? i : ((AX == 1) ? j : k);
+							int pL, pR;
+							Neighbors<BC>(p, n, &pL, &pR);
+							int interp = up ? sidx + (pR - p)*st : sidx;
+
+							gbar[o + sidx] -= dts/2.0*Xi*gsigma2[o + interp];
+							bbar[o + sidx] -= dts/2.0*Xi*bsigma2[o + interp];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Step 2a: W at the interface, with half a sweep of the sources
+	double* gm = MomentsWork(M, (1+effD)*Nc);
+	Moments(M, gbar, Nc, MOM_RHO, 1 + effD, gm);
+	Moments(M, bbar, Nc, MOM_RHO, 1, W->rhoEh);
+
+	for(int sidx = 0; sidx < Nc; sidx++){
+		W->rhoh[sidx] = gm[MOM_RHO*Nc + sidx];
+		for(int dim = 0; dim < effD; dim++){
+			W->rhovh[effD*sidx + dim] = gm[(MOM_XI + dim)*Nc + sidx] + dts/2*W->rhoh[sidx]*S->a[effD*sidx + dim];
+			W->rhoEh[sidx] += dts/2.*gm[(MOM_XI + dim)*Nc + sidx]*S->a[effD*sidx + dim];
+		}
+		W->rhoEh[sidx] += dts/2.*S->Q[sidx];
+	}
+
+	//Step 2b: original phi at the interface, in place of phibar
+	for(int sidx = 0; sidx < Nc; sidx++){
+
+		double rh = W->rhoh[sidx];
+		double U[3] = {0, 0, 0};
+		double u = 0;
+		for(int dim = 0; dim < effD; dim++){U[dim] = W->rhovh[effD*sidx + dim]/rh; u += U[dim]*W->rhovh[effD*sidx + dim]/rh;} u = sqrt(u);
+		double T = Temperature(W->rhoEh[sidx]/rh, u);
+
+		double tg = visc(T)/rh/R/T;
+		double tb = tg/Pr;
+
+		for(int vx = 0; vx < NV[0]; vx++){
+			for(int vy = 0; vy < NV[1]; vy++){
+				for(int vz = 0; vz < NV[2]; vz++){
+					long idx = sidx + (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+					double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+					double c2 = 0;
+					for(int dim = 0; dim < effD; dim++){c2 += (Xi[dim] - U[dim])*(Xi[dim] - U[dim]);}
+					double g_eq = geq(c2, rh, T);
+					double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+					double Sg = 0.;
+					double Sb = 0.;
+					if(S->on){SourceVelocity(effD, S->a + effD*sidx, S->Q[sidx], Xi, U, rh, T, R, g_eq, &Sg, &Sb);}
+
+					gbar[idx] = 2*tg/(2*tg + dts/2.)*gbar[idx] + dts/(4*tg + dts)*g_eq + dts*tg/(4*tg + dts)*Sg;
+					bbar[idx] = 2*tb/(2*tb + dts/2.)*bbar[idx] + dts/(4*tb + dts)*b_eq + dts*tb/(4*tb + dts)*Sb;
+				}
+			}
+		}
+	}
+
+	//Step 2c: flux through the two interfaces normal to the axis, into gbarp/bbarp
+	double* Fg = gbarp;
+	double* Fb = bbarp;
+	for(int vz = 0; vz < NV[2]; vz++){
+		for(int vy = 0; vy < NV[1]; vy++){
+			for(int vx = 0; vx < NV[0]; vx++){
+				long o = (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+				int v[3] = {vx, vy, vz};
+				double Xi = Co[AX][v[AX]];
+				for(int k = 0; k < Nz; k++){
+					for(int j = 0; j < Ny; j++){
+						for(int i = 0; i < Nx; i++){
+							int sidx = i + Nx*j + Nx*Ny*k;
+							int p = (AX == 0) ? i : ((AX == 1) ? j : k);
+
+							//Boundary Conditions, as Step 2c
+							double right = 1.0;
+							double left = 1.0;
+							int pL = p - 1;
+							if(BC == 0){pL = (p - 1 + n)%n;}
+							if(BC == 1){if(pL == -1){pL = 0; left = 0.; right = 0.;} if(p == n - 1){left = 0.; right = 0.;}}
+							if(BC == 2){if(pL == -1){pL = 0; left = 0.;} if(p == n - 1){right = 0.;}}
+							int sL = sidx + (pL - p)*st;
+
+							double A = Area(mesh[sidx], AX);
+							Fg[o + sidx] = Xi*A*(right*gbar[o + sidx] - left*gbar[o + sL]);
+							Fb[o + sidx] = Xi*A*(right*bbar[o + sidx] - left*bbar[o + sL]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Step 5, first half: explicit collision and sources for dtc, transport for dts
+	for(int sidx = 0; sidx < Nc; sidx++){
+
+		if(W->fixed[sidx]){continue;} // Dirichlet: no change
+
+		double V = mesh[sidx].dx*mesh[sidx].dy*mesh[sidx].dz;
+
+		double U[3] = {0, 0, 0};
+		double uo = 0;
+		for(int dim = 0; dim < effD; dim++){U[dim] = rhov[effD*sidx + dim]/rho[sidx]; uo += U[dim]*rhov[effD*sidx + dim]/rho[sidx];} uo = sqrt(uo);
+		double To = Temperature(rhoE[sidx]/rho[sidx], uo);
+		double tgo = visc(To)/rho[sidx]/R/To;
+		double tbo = tgo/Pr;
+
+		for(int vx = 0; vx < NV[0]; vx++){
+			for(int vy = 0; vy < NV[1]; vy++){
+				for(int vz = 0; vz < NV[2]; vz++){
+					long idx = sidx + (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+					double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+					double c2 = 0;
+					for(int dim = 0; dim < effD; dim++){c2 += (Xi[dim] - U[dim])*(Xi[dim] - U[dim]);}
+					double g_eqo = geq(c2, rho[sidx], To);
+					double b_eqo = g_eqo*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*To)/2;
+
+					double Sg = 0.;
+					double Sb = 0.;
+					if(S->on){SourceVelocity(effD, S->a + effD*sidx, S->Q[sidx], Xi, U, rho[sidx], To, R, g_eqo, &Sg, &Sb);}
+
+					g[idx] = g[idx] + dtc/2*(g_eqo-g[idx])/tgo - dts/V*Fg[idx] + dtc*Sg;
+					b[idx] = b[idx] + dtc/2*(b_eqo-b[idx])/tbo - dts/V*Fb[idx] + dtc*Sb;
+				}
+			}
+		}
+	}
+
+	//Step 4: W from the moments of the flux
+	double* Fm = MomentsWork(M, (2+effD)*Nc);
+	Moments(M, Fg, Nc, MOM_RHO, 1 + effD, Fm);
+	Moments(M, Fb, Nc, MOM_RHO, 1, Fm + (1+effD)*Nc);
+
+	for(int sidx = 0; sidx < Nc; sidx++){
+
+		double V = mesh[sidx].dx*mesh[sidx].dy*mesh[sidx].dz;
+
+		double Srhov[3] = {0, 0, 0};
+		double SrhoE = 0;
+		if(S->on && !W->fixed[sidx]){
+			SrhoE = S->Q[sidx];
+			for(int dim = 0; dim < effD; dim++){
+				Srhov[dim] = rho[sidx]*S->a[effD*sidx + dim];
+				SrhoE += rhov[effD*sidx + dim]*S->a[effD*sidx + dim];
+			}
+		}
+
+		rho[sidx] += -(dts/V*Fm[MOM_RHO*Nc + sidx]);
+		for(int dim = 0; dim < effD; dim++){
+			rhov[effD*sidx + dim] += -dts/V*Fm[(MOM_XI + dim)*Nc + sidx] + dtc*Srhov[dim];
+		}
+		rhoE[sidx] += -dts/V*Fm[(1+effD)*Nc + sidx] + dtc*SrhoE;
+	}
+
+	//Step 5, second half: implicit collision with the new W
+	for(int sidx = 0; sidx < Nc; sidx++){
+
+		if(W->fixed[sidx]){continue;}
+
+		double U[3] = {0, 0, 0};
+		double u = 0;
+		for(int dim = 0; dim < effD; dim++){U[dim] = rhov[effD*sidx + dim]/rho[sidx]; u += U[dim]*rhov[effD*sidx + dim]/rho[sidx];} u = sqrt(u);
+		double T = Temperature(rhoE[sidx]/rho[sidx], u);
+		double tg = visc(T)/rho[sidx]/R/T;
+		double tb = tg/Pr;
+
+		for(int vx = 0; vx < NV[0]; vx++){
+			for(int vy = 0; vy < NV[1]; vy++){
+				for(int vz = 0; vz < NV[2]; vz++){
+					long idx = sidx + (long)Nc*(vx + NV[0]*vy + NV[0]*NV[1]*vz);
+					double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
+
+					double c2 = 0;
+					for(int dim = 0; dim < effD; dim++){c2 += (Xi[dim] - U[dim])*(Xi[dim] - U[dim]);}
+					double g_eq = geq(c2, rho[sidx], T);
+					double b_eq = g_eq*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
+
+					g[idx] = (g[idx] + dtc/2*g_eq/tg)/(1+dtc/2/tg);
+					b[idx] = (b[idx] + dtc/2*b_eq/tb)/(1+dtc/2/tb);
+				}
+			}
+		}
+	}
+}
+
+template <int D, int AX, int BC> static void SelectSweepLim(Sweep* W, int limiter){
+
+	if(limiter == LIM_MINMOD){W->kernel[AX] = SweepK<D, AX, BC, LIM_MINMOD>;}
+	else if(limiter == LIM_MC){W->kernel[AX] = SweepK<D, AX, BC, LIM_MC>;}
+	else if(limiter == LIM_SUPERBEE){W->kernel[AX] = SweepK<D, AX, BC, LIM_SUPERBEE>;}
+	else{W->kernel[AX] = SweepK<D, AX, BC, LIM_VANLEER>;}
+}
+
+template <int D, int AX> static void SelectSweepBC(Sweep* W, int bc, int limiter){
+
+	if(bc == 0){SelectSweepLim<D, AX, 0>(W, limiter);}
+	else if(bc == 1){SelectSweepLim<D, AX, 1>(W, limiter);}
+	else{SelectSweepLim<D, AX, 2>(W, limiter);}
+}
+
+template <int D> static void SelectSweep(Sweep* W, int* BCs, int limiter){
+
+	SelectSweepBC<D, 0>(W, BCs[0], limiter);
+	if constexpr(D > 1){SelectSweepBC<D, 1>(W, BCs[1], limiter);}
+	if constexpr(D > 2){SelectSweepBC<D, 2>(W, BCs[2], limiter);}
+}
+
+void SweepInit(Sweep* W, int* N, int* NV, int effD, int* BCs, int limiter, double* rh){
+
+	int Nc = N[0]*N[1]*N[2];
+	long Ng = (long)Nc*NV[0]*NV[1]*NV[2];
+
+	//Strang sequence: the outer axes twice for half the step, the innermost once for the whole step
+	W->n = 2*effD - 1;
+	for(int s = 0; s < W->n; s++){
+		W->axis[s] = (s < effD) ? s : W->n - 1 - s;
+		W->frac[s] = (W->axis[s] == effD - 1) ? 1.0 : 0.5;
+	}
+
+	W->gsigma = new double[Ng];
+	W->bsigma = new double[Ng];
+	W->gsigma2 = new double[Ng];
+	W->bsigma2 = new double[Ng];
+	W->gbar = new double[Ng];
+	W->bbar = new double[Ng];
+	W->rhoh = new double[Nc];
+	W->rhovh = new double[Nc*effD];
+	W->rhoEh = new double[Nc];
+
+	//Cells on a Dirichlet boundary of any axis are never updated
+	W->fixed = new char[Nc];
+	for(int k = 0; k < N[2]; k++){
+		for(int j = 0; j < N[1]; j++){
+			for(int i = 0; i < N[0]; i++){
+				W->fixed[i + N[0]*j + N[0]*N[1]*k] = (BCs[0] == 1 && (i == 0 || i == N[0] - 1)) ||
+				                                     (BCs[1] == 1 && (j == 0 || j == N[1] - 1)) ||
+				                                     (BCs[2] == 1 && (k == 0 || k == N[2] - 1));
+			}
+		}
+	}
+
+	for(int d = 0; d < 3; d++){W->rh[d] = rh[d];}
+
+	if(effD == 1){SelectSweep<1>(W, BCs, limiter);}
+	if(effD == 2){SelectSweep<2>(W, BCs, limiter);}
+	if(effD == 3){SelectSweep<3>(W, BCs, limiter);}
+}
+
+void SweepFree(Sweep* W){
+
+	delete[] W->gsigma; delete[] W->bsigma; delete[] W->gsigma2; delete[] W->bsigma2; delete[] W->gbar; delete[] W->bbar;
+	delete[] W->rhoh; delete[] W->rhovh; delete[] W->rhoEh;
+	delete[] W->fixed;
+}
+
+int EvolveSplit(Sweep* W, double* g, double* b, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, Cell* mesh, double* Tdump, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
+
+	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
+
+	int dump = (*dt < calcdt);
+
+
+	//Evolution Cycle
+	Step3(S, rho, rhov, rhoE, N, effD, 0, N[effD-1]); //Sources from W at the start of the step, for every sweep
+
+	for(int s = 0; s < W->n; s++){
+		double dts = W->frac[s]*(*dt);
+		SK->Step1a(g, b, W->gbar, W->bbar, gbarp, bbarp, S, rho, rhov, rhoE, dts, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, 0, N[effD-1]);
+		W->kernel[W->axis[s]](W, g, b, gbarp, bbarp, S, rho, rhov, rhoE, dts, dts/effD, mesh, Co_X, Co_Y, Co_Z, M, R, K, Pr, N, NV);
+	}
+
+	return dump;
+}
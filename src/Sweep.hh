@@ -0,0 +1,50 @@
+#ifndef SWEEP_HH
+#define SWEEP_HH
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Evolution.hh"
+
+// Directionally split evolution (-x 1). A timestep is a Strang sequence of 1D sweeps,
+//   2D: x(dt/2) y(dt) x(dt/2),   3D: x(dt/2) y(dt/2) z(dt) y(dt/2) x(dt/2),
+// each a full DUGKS step (Steps 1a to 4/5) along one axis only. The interface values and slopes
+// of a sweep are along its axis alone, so the scratch is Nc*Nv per array instead of the
+// Nc*Nv*effD (interfaces, slopes) and Nc*Nv*effD^2 (second slopes) of the unsplit step.
+// The sweeps take effD times dt of transport in total, so each one applies dt_s/effD of collision
+// and sources in the cell update (the half steps to the interfaces use the sweep's own dt_s/2).
+// In 1D the single sweep is the unsplit step, bit for bit.
+
+struct Sweep{
+
+	int n;          // Sweeps per timestep
+	int axis[5];
+	double frac[5]; // dt_s/dt
+
+	// One axis at a time, idx = sidx + Nc*v
+	double* gsigma;
+	double* bsigma;
+	double* gsigma2;
+	double* bsigma2;
+	double* gbar;   // Interface values, then the original distribution at the interface
+	double* bbar;
+
+	// W at the interface of the sweep's axis
+	double* rhoh;
+	double* rhovh;  // rhovh[effD*sidx + dim]
+	double* rhoEh;
+
+	char* fixed;    // Cells on a Dirichlet boundary, never updated
+	double rh[3];   // 1/spacing of uniform axes, 0 otherwise (StepKernels); the kernels are compiled per limiter as Step 1b
+
+	void (*kernel[3])(Sweep* W, double* g, double* b, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double dts, double dtc, Cell* mesh, double* Co_X, double* Co_Y, double* Co_Z, MomentBasis* M, double R, double K, double Pr, int* N, int* NV);
+};
+
+void SweepInit(Sweep* W, int* N, int* NV, int effD, int* BCs, int limiter, double* rh);
+void SweepFree(Sweep* W);
+
+// Same contract as Evolve: sets *dt and returns 1 if the step ends at a dump. gbarp/bbarp are the
+// Step 1a scratch and hold the flux afterwards, as in Evolve.
+int EvolveSplit(Sweep* W, double* g, double* b, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, Cell* mesh, double* Tdump, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Tiles.hh"
+
+static int Threads(int nthreads){
+
+	if(nthreads <= 0){nthreads = std::thread::hardware_concurrency();}
+	return nthreads > 0 ? nthreads : 1;
+}
+
+static void Push(Tiles* G, int th, int task){
+
+	std::lock_guard<std::mutex> l(G->queue[th].lock);
+	G->queue[th].tasks.push_back(task);
+}
+
+//Newest task of our own deque, else the oldest of the next thread that has one
+static int Take(Tiles* G, int th, int* task){
+
+	for(int k = 0; k < G->nthreads; k++){
+		TileQueue* Q = &G->queue[(th + k)%G->nthreads];
+		std::lock_guard<std::mutex> l(Q->lock);
+		if(Q->tasks.empty()){continue;}
+		if(k == 0){*task = Q->tasks.back(); Q->tasks.pop_back();}
+		else{*task = Q->tasks.front(); Q->tasks.pop_front();}
+		return 1;
+	}
+	return 0;
+}
+
+//Run tasks until every task of the timestep is done
+static void Work(Tiles* G, int th){
+
+	while(G->done.load() < G->ntasks){
+		int task;
+		if(!Take(G, th, &task)){std::this_thread::yield(); continue;}
+
+		int phase = task/G->n;
+		int t = task%G->n;
+		G->run(phase, G->s0[t], G->s0[t+1], th);
+
+		for(int e = G->first[task]; e < G->first[task+1]; e++){
+			if(G->wait[G->succ[e]].fetch_sub(1) == 1){Push(G, th, G->succ[e]);}
+		}
+		G->done.fetch_add(1); //After the pushes, so done == ntasks means nothing is left anywhere
+	}
+}
+
+static void PoolThread(Tiles* G, int th){
+
+	int seen = 0;
+	while(1){
+		{
+			std::unique_lock<std::mutex> l(G->lock);
+			G->start.wait(l, [&]{return G->quit || G->generation != seen;});
+			if(G->quit){return;}
+			seen = G->generation;
+		}
+		Work(G, th);
+		{
+			std::lock_guard<std::mutex> l(G->lock);
+			G->idle++;
+		}
+		G->finish.notify_one();
+	}
+}
+
+void TilesInit(Tiles* G, int nslabs, int nthreads, int* N, int* NV, int effD, int* BCs, MomentBasis* M){
+
+	int Ns = N[effD-1];
+	int Nc = N[0]*N[1]*N[2];
+	int n = nslabs < 1 ? 1 : (nslabs > Ns ? Ns : nslabs);
+
+	G->n = n;
+	G->s0 = new int[n + 1];
+	for(int t = 0; t <= n; t++){G->s0[t] = (long)Ns*t/n;}
+	G->nthreads = Threads(nthreads);
+
+	//Neighbours of each slab, itself included, without repeats
+	int* nb = new int[3*n];
+	int* nnb = new int[n];
+	for(int t = 0; t < n; t++){
+		int c[3] = {t - 1, t, t + 1};
+		nnb[t] = 0;
+		for(int m = 0; m < 3; m++){
+			int u = c[m];
+			if(BCs[effD-1] == 0){u = (u + n)%n;}
+			if(u < 0 || u >= n){continue;}
+			int seen = 0;
+			for(int q = 0; q < nnb[t]; q++){seen |= (nb[3*t + q] == u);}
+			if(!seen){nb[3*t + nnb[t]++] = u;}
+		}
+	}
+
+	//Phases that read neighbouring slabs of the previous phase, see Tiles.hh
+	const int stencil[TILE_PHASES] = {0, 1, 1, 1, 0, 1, 0};
+
+	G->ntasks = TILE_PHASES*n;
+	G->npred = new int[G->ntasks];
+	G->first = new int[G->ntasks + 1];
+	for(int i = 0; i < G->ntasks; i++){G->npred[i] = 0;}
+
+	//Successors of task (phase, u) are the tasks of phase + 1 that read slab u
+	int* nsucc = new int[G->ntasks];
+	for(int i = 0; i < G->ntasks; i++){nsucc[i] = 0;}
+	for(int phase = 1; phase < TILE_PHASES; phase++){
+		for(int t = 0; t < n; t++){
+			int np = stencil[phase] ? nnb[t] : 1;
+			for(int q = 0; q < np; q++){
+				int u = stencil[phase] ? nb[3*t + q] : t;
+				nsucc[(phase - 1)*n + u]++;
+				G->npred[phase*n + t]++;
+			}
+		}
+	}
+	G->first[0] = 0;
+	for(int i = 0; i < G->ntasks; i++){G->first[i+1] = G->first[i] + nsucc[i]; nsucc[i] = 0;}
+	G->succ = new int[G->first[G->ntasks]];
+	for(int phase = 1; phase < TILE_PHASES; phase++){
+		for(int t = 0; t < n; t++){
+			int np = stencil[phase] ? nnb[t] : 1;
+			for(int q = 0; q < np; q++){
+				int u = stencil[phase] ? nb[3*t + q] : t;
+				int p = (phase - 1)*n + u;
+				G->succ[G->first[p] + nsucc[p]++] = phase*n + t;
+			}
+		}
+	}
+	delete[] nb;
+	delete[] nnb;
+	delete[] nsucc;
+
+	G->wait = new std::atomic<int>[G->ntasks];
+	G->queue = new TileQueue[G->nthreads];
+
+	G->gm = new double[(1+effD)*Nc*effD];
+	G->Fm = new double[(2+effD)*Nc];
+	G->ntree = MomentsTreeSize(M);
+	G->tree = new double[G->nthreads*G->ntree];
+
+	G->generation = 0;
+	G->idle = 0;
+	G->quit = 0;
+	for(int th = 1; th < G->nthreads; th++){G->pool.push_back(std::thread(PoolThread, G, th));}
+}
+
+void TilesFree(Tiles* G){
+
+	{
+		std::lock_guard<std::mutex> l(G->lock);
+		G->quit = 1;
+	}
+	G->start.notify_all();
+	for(size_t th = 0; th < G->pool.size(); th++){G->pool[th].join();}
+	G->pool.clear();
+
+	delete[] G->s0;
+	delete[] G->npred;
+	delete[] G->first;
+	delete[] G->succ;
+	delete[] G->wait;
+	delete[] G->queue;
+	delete[] G->gm;
+	delete[] G->Fm;
+	delete[] G->tree;
+}
+
+int EvolveTiled(Tiles* G, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax){
+
+	//Find timestep
+	double calcdt = StableTimeStep(N, Vmax);
+
+	*dt = TimeStep(calcdt, dtdump-*Tdump, Tf-Tsim);
+
+	int dump = (*dt < calcdt);
+	double h = *dt;
+
+	G->run = [&](int phase, int s0, int s1, int th){
+		double* tree = G->tree + th*G->ntree;
+		switch(phase){
+			case 0:
+				Step3(S, rho, rhov, rhoE, N, effD, s0, s1);
+				SK->Step1a(g, b, gbar, bbar, gbarp, bbarp, S, rho, rhov, rhoE, h, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+				break;
+			case 1:
+			case 2:
+				SK->Step1b(gbarp, bbarp, gsigma, bsigma, gsigma2, bsigma2, mesh, SK->rh, gbarpbound, bbarpbound, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, phase - 1, phase, s0, s1);
+				break;
+			case 3:
+				SK->Step1c(gbar, bbar, gbarpbound, bbarpbound, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, gsigma2, bsigma2, h, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+				break;
+			case 4:
+				Step2a(gbar, bbar, M, S, h, rhoh, rhovh, rhoEh, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD, s0, s1, G->gm, tree);
+				SK->Step2b(gbar, bbar, S, h, rhoh, rhovh, rhoEh, Co_X, Co_Y, Co_Z, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+				break;
+			case 5:
+				SK->Step2c(gbar, bbar, Co_X, Co_Y, Co_Z, mesh, gbarp, bbarp, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1);
+				break;
+			case 6:
+				SK->Step4and5(rho, rhov, rhoE, h, mesh, gbarp, bbarp, Co_X, Co_Y, Co_Z, M, S, g, b, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, s0, s1, G->Fm, tree);
+				break;
+		}
+	};
+
+	//Phase 0 of every slab is ready, dealt round robin
+	for(int i = 0; i < G->ntasks; i++){G->wait[i].store(G->npred[i]);}
+	G->done.store(0);
+	for(int t = 0; t < G->n; t++){G->queue[t%G->nthreads].tasks.push_back(t);}
+
+	{
+		std::lock_guard<std::mutex> l(G->lock);
+		G->generation++;
+		G->idle = 0;
+	}
+	G->start.notify_all();
+
+	Work(G, 0);
+
+	//The pool must be out of Work (and done with run's captures) before returning
+	std::unique_lock<std::mutex> l(G->lock);
+	G->finish.wait(l, [&]{return G->idle == G->nthreads - 1;});
+
+	return dump;
+}
@@ -0,0 +1,85 @@
+#ifndef TILES_HH
+#define TILES_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Mesh.hh"
+#include "Moments.hh"
+#include "Source.hh"
+#include "Evolution.hh"
+
+// Tiled evolution (-g slabs). The last active axis is cut into slabs and a timestep is a graph of
+// (phase, slab) tasks instead of one pass over the whole domain per step:
+//   phase 0  Steps 3 and 1a                 needs nothing
+//   phase 1  Step 1b, slopes at the cells   needs phase 0 of the slab and its neighbours
+//   phase 2  Step 1b, interface values      needs phase 1 of the slab and its neighbours
+//   phase 3  Step 1c                        needs phase 2 of the slab and its neighbours
+//   phase 4  Steps 2a and 2b                needs phase 3 of the slab
+//   phase 5  Step 2c                        needs phase 4 of the slab and its neighbours
+//   phase 6  Steps 4 and 5                  needs phase 5 of the slab
+// The stencils reach one cell, so a slab only waits for its two neighbours (wrapped on a periodic axis).
+// The same edges cover the recycled memory: Step 2c writes the flux into gbarp, which Step 1b of the
+// neighbours reads, and it comes after them through phases 3 and 4.
+// A slab goes on to its next phase as soon as its neighbours allow, while its data is still in cache,
+// and there is no barrier between the phases of a timestep. Each cell does the same arithmetic as in
+// Evolve, so the results are bitwise identical for any number of slabs and threads.
+//
+// The tasks run on a pool of threads with work stealing. Each thread has a deque, runs its newest task
+// (the one whose inputs are most likely still in its cache) and, when the deque is empty, steals the
+// oldest task of another thread. A finished task pushes the successors it releases onto the deque of
+// the thread that ran it. The pool is started once and waits between timesteps.
+
+#define TILE_PHASES 7
+
+struct TileQueue{
+
+	std::mutex lock;
+	std::deque<int> tasks;
+};
+
+struct Tiles{
+
+	int n;              // Slabs
+	int* s0;            // Slab t is s0[t] <= s < s0[t+1] along the last active axis
+	int nthreads;
+
+	// Task phase*n + t; its successors are succ[first[i]] to succ[first[i+1]-1]
+	int ntasks;
+	int* npred;
+	int* first;
+	int* succ;
+	std::atomic<int>* wait; // Predecessors of each task not yet done, this timestep
+	std::atomic<int> done;  // Tasks done, this timestep
+	TileQueue* queue;       // One per thread
+
+	// Moment scratch, the slabs write disjoint columns of gm and Fm; one reproducible tree per thread
+	double* gm;
+	double* Fm;
+	double* tree;
+	long ntree;
+
+	// Pool, thread 0 is the caller
+	std::vector<std::thread> pool;
+	std::mutex lock;
+	std::condition_variable start;
+	std::condition_variable finish;
+	int generation;     // Timesteps started
+	int idle;           // Pool threads done with the current timestep
+	int quit;
+	std::function<void(int phase, int s0, int s1, int thread)> run;
+};
+
+// nslabs is clamped to [1, N[effD-1]], nthreads <= 0 is one per core.
+void TilesInit(Tiles* G, int nslabs, int nthreads, int* N, int* NV, int effD, int* BCs, MomentBasis* M);
+void TilesFree(Tiles* G);
+
+// Same contract as Evolve.
+int EvolveTiled(Tiles* G, double* g, double* b, double* gbar, double* bbar, double* gbarp, double* bbarp, Source* S, double* rho, double* rhov, double* rhoE, double* dt, double Tf, double Tsim, double dtdump, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, MomentBasis* M, StepKernels* SK, double* gsigma, double* bsigma, double* gsigma2, double* bsigma2, Cell* mesh, double* gbarpbound, double* bbarpbound, double* rhoh, double* rhovh, double* rhoEh, double* Tdump, int* BCs, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double* Vmax);
+
+#endif
@@ -0,0 +1,276 @@
+import argparse
+import datetime
+import glob
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+# Benchmarks the test problems of both versions at fixed step counts and records, one JSON line per run:
+# time to solution, cell-velocity updates per second, peak RSS and the L1 density error, against the exact
+# Riemann solution for Sod and against a stored reference run for the other problems.
+#
+#   python3 bench.py --cpp ./cdugks                       C++ problems, every preset
+#   python3 bench.py --regent "regent ../regentsrc/Main.rg -c 4" --preset small
+#   python3 bench.py --cpp ./cdugks --save-refs           store the final states as the references
+#   python3 bench.py --compare old.jsonl new.jsonl        ratios between two result files
+#   python3 bench.py --regent "..." --partitions 4         time the 4 best partitions of the cost model (-P)
+#
+# Runs use -n <steps> -m <cells> -o 0 and a selection (-s) that writes every cell at the last step,
+# so both versions report their final state the same way (Output.hh). Results are appended to
+# bench_results.jsonl with the commit they were run on. The references live in bench_refs/, one
+# file per version, problem and preset, and are only meaningful for the same preset and step count.
+
+# version, -p, name, dimensions
+PROBLEMS = [
+	('cpp', 1, 'sod', 1),
+	('cpp', 2, 'khi', 2),
+	('regent', 1, 'sod', 1),
+	('regent', 2, 'khi', 2),
+	('regent', 3, 'shear', 2),
+	('regent', 4, 'ramped_khi', 2),
+	('regent', 5, 'nonuniform_shear', 2),
+	('regent', 6, 'relaxation', 1),
+	('regent', 7, 'blob', 2),
+	('regent', 8, 'thermoacoustic', 1),
+	('regent', 9, 'gresho', 2),
+	('regent', 10, 'sine_collapse', 1),
+	('regent', 11, 'isothermal_shock', 1),
+]
+
+# cells along the resolved axes in 1D and 2D, timesteps
+PRESETS = {
+	'small':  (128, 32, 20),
+	'medium': (512, 64, 20),
+	'large':  (2048, 128, 10),
+}
+
+
+def sod_exact(x, t, gma = 1.4, rhoL = 1.0, PL = 1.0, rhoR = 0.125, PR = 0.1, x0 = 0.5):
+
+	# Exact Riemann solution for gas at rest on both sides (Toro, chapter 4)
+	cL = np.sqrt(gma*PL/rhoL)
+	cR = np.sqrt(gma*PR/rhoR)
+
+	def f(P, rho, Pk, c):
+		if P > Pk:
+			A = 2/((gma + 1)*rho)
+			B = (gma - 1)/(gma + 1)*Pk
+			return (P - Pk)*np.sqrt(A/(P + B))
+		return 2*c/(gma - 1)*((P/Pk)**((gma - 1)/(2*gma)) - 1)
+
+	lo, hi = 1e-12, 10*max(PL, PR)
+	for _ in range(200):
+		P = 0.5*(lo + hi)
+		if f(P, rhoL, PL, cL) + f(P, rhoR, PR, cR) > 0:
+			hi = P
+		else:
+			lo = P
+	Ps = 0.5*(lo + hi)
+	us = 0.5*(f(Ps, rhoR, PR, cR) - f(Ps, rhoL, PL, cL))
+
+	# Left rarefaction, contact at us, right shock at SR
+	rhosL = rhoL*(Ps/PL)**(1/gma)
+	csL = cL*(Ps/PL)**((gma - 1)/(2*gma))
+	rhosR = rhoR*(Ps/PR + (gma - 1)/(gma + 1))/((gma - 1)/(gma + 1)*Ps/PR + 1)
+	SR = np.sqrt((gma + 1)/(2*gma)*Ps/PR + (gma - 1)/(2*gma))*cR
+
+	s = (np.asarray(x) - x0)/max(t, 1e-300)
+	rho = np.empty_like(s)
+	for n, v in enumerate(s):
+		if v < -cL:
+			rho[n] = rhoL
+		elif v < us - csL:
+			rho[n] = rhoL*(2/(gma + 1) + (gma - 1)/((gma + 1)*cL)*(-v))**(2/(gma - 1))
+		elif v < us:
+			rho[n] = rhosL
+		elif v < SR:
+			rho[n] = rhosR
+		else:
+			rho[n] = rhoR
+	return rho
+
+
+def commit():
+
+	try:
+		here = os.path.dirname(os.path.abspath(__file__))
+		sha = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], cwd = here, capture_output = True, text = True).stdout.strip()
+		dirty = subprocess.run(['git', 'status', '--porcelain', '--untracked-files=no'], cwd = here, capture_output = True, text = True).stdout.strip()
+		return sha + ('+' if dirty else '')
+	except OSError:
+		return 'unknown'
+
+
+def run(cmd, cwd):
+
+	# Wall time and the peak RSS of this child alone (wait4), in MB
+	t0 = time.perf_counter()
+	with open(os.path.join(cwd, 'log.txt'), 'w') as log:
+		p = subprocess.Popen(cmd, cwd = cwd, stdout = log, stderr = subprocess.STDOUT)
+		_, status, ru = os.wait4(p.pid, 0)
+		p.returncode = os.waitstatus_to_exitcode(status)
+	wall = time.perf_counter() - t0
+	rss = ru.ru_maxrss/1024 if sys.platform != 'darwin' else ru.ru_maxrss/1024**2
+	with open(os.path.join(cwd, 'log.txt')) as log:
+		out = log.read()
+	return p.returncode, wall, rss, out
+
+
+def final_state(cwd):
+
+	# Last write of the 'bench' selection; the Regent version writes one file per piece
+	files = sorted(glob.glob(os.path.join(cwd, 'Data', 'bench[0-9][0-9][0-9][0-9]*.txt')))
+	if not files:
+		return None
+	last = os.path.basename(files[-1])[5:9]
+	pieces = [f for f in files if os.path.basename(f)[5:9] == last]
+	iters, Tsim, rows = 0, 0.0, []
+	for f in pieces:
+		with open(f) as fp:
+			m = re.match(r'# iter = (\d+), Tsim = (\S+)', fp.readline())
+			iters, Tsim = int(m.group(1)), float(m.group(2))
+		a = np.loadtxt(f, ndmin = 2)
+		if a.size:
+			rows.append(a)
+	a = np.concatenate(rows)
+	a = a[np.lexsort((a[:, 0], a[:, 1], a[:, 2]))]
+	return iters, Tsim, a
+
+
+def bench_one(version, p, name, dims, preset, args, extra = []):
+
+	cells, steps = PRESETS[preset][dims - 1], PRESETS[preset][2]
+	base = shlex.split(args.cpp if version == 'cpp' else args.regent)
+	cwd = os.path.join(args.workdir, '%s_%s_%s' % (version, name, preset))
+	os.makedirs(os.path.join(cwd, 'Data'), exist_ok = True)
+	for f in glob.glob(os.path.join(cwd, 'Data', '*')):
+		os.remove(f)
+	with open(os.path.join(cwd, 'select.txt'), 'w') as fp:
+		fp.write('slice bench %d 2 0\n' % steps) # Every cell (the problems have N[2] = 1), at the last step
+
+	cmd = base + ['-p', str(p), '-n', str(steps), '-m', str(cells), '-o', '0', '-s', 'select.txt']
+	if version == 'cpp':
+		cmd += ['-i', '0']
+	cmd += shlex.split(args.flags) + extra
+	code, wall, rss, out = run(cmd, cwd)
+
+	r = {'commit': args.commit, 'date': args.date, 'version': version, 'problem': p, 'name': name, 'preset': preset,
+	     'flags': args.flags, 'status': code, 'wall_s': round(wall, 4), 'peak_rss_mb': round(rss, 1)}
+	mN = re.search(r'N = \{(\d+), (\d+), (\d+)\}', out)
+	mV = re.search(r'NV = \{(\d+), (\d+), (\d+)\}', out)
+	mS = re.search(r'Mean step time = (\S+) seconds', out)
+	mP = re.search(r'Partitioning as \{(\d+), (\d+), (\d+),', out)
+	if mP is not None:
+		r['partition'] = [int(v) for v in mP.groups()]
+	state = final_state(cwd)
+	if code != 0 or mN is None or mV is None or state is None:
+		r['error'] = 'run failed, see %s' % os.path.join(cwd, 'log.txt')
+		return r, None
+
+	N = [int(v) for v in mN.groups()]
+	NV = [int(v) for v in mV.groups()]
+	iters, Tsim, a = state
+	updates = float(np.prod(N))*float(np.prod(NV))*iters
+	r.update({'N': N, 'NV': NV, 'steps': iters, 'Tsim': Tsim, 'updates_per_s': updates/wall})
+	if mS is not None:
+		r['step_s'] = float(mS.group(1))
+		r['updates_per_s_steady'] = float(np.prod(N))*float(np.prod(NV))/r['step_s']
+
+	rho = a[:, 3]
+	if name == 'sod':
+		x = (a[:, 0] + 0.5)/N[0]
+		exact = sod_exact(x, Tsim)
+		r['err_L1'] = float(np.abs(rho - exact).mean())
+		r['err_ref'] = 'exact'
+	else:
+		ref = os.path.join(args.refs, '%s_%s_%s.txt' % (version, name, preset))
+		if os.path.exists(ref):
+			b = np.loadtxt(ref, ndmin = 2)
+			if b.shape[0] == rho.shape[0]:
+				r['err_L1'] = float(np.abs(rho - b[:, 3]).sum()/np.abs(b[:, 3]).sum())
+				r['err_ref'] = os.path.basename(ref)
+	return r, a
+
+
+def compare(old, new):
+
+	def load(f):
+		d = {}
+		with open(f) as fp:
+			for line in fp:
+				r = json.loads(line)
+				d[(r['version'], r['name'], r['preset'], r.get('flags', ''), r.get('partrank', 0))] = r
+		return d
+	A, B = load(old), load(new)
+	print('%-8s %-18s %-7s %12s %12s %8s %10s %10s' % ('version', 'problem', 'preset', 'old upd/s', 'new upd/s', 'speedup', 'old err', 'new err'))
+	for k in sorted(set(A) & set(B)):
+		a, b = A[k], B[k]
+		if 'updates_per_s' not in a or 'updates_per_s' not in b:
+			continue
+		ea = '%.3e' % a['err_L1'] if 'err_L1' in a else '-'
+		eb = '%.3e' % b['err_L1'] if 'err_L1' in b else '-'
+		print('%-8s %-18s %-7s %12.4g %12.4g %8.3f %10s %10s' % (k[0], k[1], k[2], a['updates_per_s'], b['updates_per_s'], b['updates_per_s']/a['updates_per_s'], ea, eb))
+
+
+if __name__ == '__main__':
+
+	ap = argparse.ArgumentParser(description = 'Benchmark the test problems of both versions')
+	ap.add_argument('--cpp', help = 'C++ binary, e.g. ./cdugks')
+	ap.add_argument('--regent', help = 'Regent command, e.g. "regent ../regentsrc/Main.rg -c 4"')
+	ap.add_argument('--preset', action = 'append', choices = sorted(PRESETS), help = 'preset(s) to run (default all)')
+	ap.add_argument('--problem', action = 'append', help = 'problem name(s) to run (default all)')
+	ap.add_argument('--flags', default = '', help = 'extra flags passed to every run, e.g. "-g 8 -t 4"')
+	ap.add_argument('--out', default = 'bench_results.jsonl')
+	ap.add_argument('--refs', default = 'bench_refs')
+	ap.add_argument('--save-refs', action = 'store_true', help = 'store the final states as the references')
+	ap.add_argument('--workdir', default = 'bench_runs')
+	ap.add_argument('--partitions', type = int, default = 0, metavar = 'K', help = 'Regent: run the K best partitions of the cost model (-P 0 .. K-1) and report the fastest')
+	ap.add_argument('--compare', nargs = 2, metavar = ('OLD', 'NEW'))
+	args = ap.parse_args()
+
+	if args.compare:
+		compare(*args.compare)
+		sys.exit(0)
+	if not args.cpp and not args.regent:
+		ap.error('give --cpp and/or --regent')
+	if args.cpp:
+		args.cpp = os.path.abspath(args.cpp) if os.path.exists(args.cpp) else args.cpp
+
+	args.commit = commit()
+	args.date = datetime.datetime.now().isoformat(timespec = 'seconds')
+	presets = args.preset or ['small', 'medium', 'large']
+	os.makedirs(args.refs, exist_ok = True)
+
+	failed = 0
+	with open(args.out, 'a') as out:
+		for version, p, name, dims in PROBLEMS:
+			if (version == 'cpp' and not args.cpp) or (version == 'regent' and not args.regent):
+				continue
+			if args.problem and name not in args.problem:
+				continue
+			for preset in presets:
+				ranks = range(args.partitions) if version == 'regent' and args.partitions > 0 else [None]
+				best = None
+				for k in ranks:
+					r, a = bench_one(version, p, name, dims, preset, args, [] if k is None else ['-P', str(k)])
+					if k is not None:
+						r['partrank'] = k
+					if args.save_refs and a is not None and not k:
+						np.savetxt(os.path.join(args.refs, '%s_%s_%s.txt' % (version, name, preset)), a, header = 'Tsim = %.10e, commit %s' % (r['Tsim'], r['commit']))
+					out.write(json.dumps(r) + '\n')
+					out.flush()
+					failed += 'error' in r
+					err = ' L1 %.3e (%s)' % (r['err_L1'], r['err_ref']) if 'err_L1' in r else ''
+					part = ' -P %d %s' % (k, r.get('partition')) if k is not None else ''
+					print('%-6s %-18s %-7s %s%s' % (version, name, preset, r.get('error') or '%8.3f s  %10.4g upd/s  %7.1f MB%s' % (r['wall_s'], r['updates_per_s'], r['peak_rss_mb'], err), part))
+					if 'error' not in r and (best is None or r.get('step_s', r['wall_s']) < best.get('step_s', best['wall_s'])):
+						best = r
+				if len(ranks) > 1 and best is not None:
+					print('%-6s %-18s %-7s fastest: -P %d %s' % (version, name, preset, best['partrank'], best.get('partition')))
+	sys.exit(1 if failed else 0)
@@ -0,0 +1,111 @@
+import argparse
+import glob
+import mmap
+import os
+import struct
+import time
+
+import numpy as np
+
+# Watches a running solver through the live state it publishes with -j (see LiveFormat.hh), without touching Data/.
+#
+#   python3 live.py                        newest /dev/shm/cdugks_*, print a summary of every new state
+#   python3 live.py --name /cdugks_1234 --plot
+#
+# The copy of a buffer is kept only if its seq is even and unchanged across the copy (a seqlock), as in LiveReader.cc.
+
+MAGIC = b"CDUGKSLV"
+VERSION = 1
+HEADER_BYTES = 256
+HEADER = struct.Struct("<8s12iqqQ")   # magic .. latest, ncells, pid, published
+SLOT = struct.Struct("<QQqdd")        # seq, published, iter, Tsim, dt
+
+
+def segment_path(name):
+	if name is not None:
+		return "/dev/shm/" + name.lstrip("/")
+	paths = glob.glob("/dev/shm/cdugks_*")
+	if not paths:
+		raise SystemExit("No live segment in /dev/shm, is the solver running with -j?")
+	return max(paths, key=os.path.getmtime)
+
+
+def header(buf):
+	f = HEADER.unpack_from(buf, 0)
+	h = {"magic": f[0], "version": f[1], "effD": f[2], "N": f[3:6], "n": f[6:9], "stride": f[9], "nvar": f[10],
+	     "done": f[11], "latest": f[12], "ncells": f[13], "pid": f[14], "published": f[15]}
+	if h["magic"] != MAGIC or h["version"] != VERSION:
+		raise SystemExit("Not a live segment of version %d" % VERSION)
+	return h
+
+
+def read(buf, seen, retries=64):
+	"""Latest consistent state as (header, slot, fields), or None if there is nothing newer than publication seen."""
+	for attempt in range(retries):
+		h = header(buf)
+		k = h["latest"]
+		if k < 0 or h["published"] == seen:
+			return None
+		off = HEADER.size + k*SLOT.size
+		s1 = SLOT.unpack_from(buf, off)
+		if s1[0] & 1:
+			continue
+		n = h["nvar"]*h["ncells"]
+		data = np.frombuffer(buf, dtype="<f8", count=n, offset=HEADER_BYTES + k*n*8).copy()
+		s2 = SLOT.unpack_from(buf, off)
+		if s2[0] != s1[0]:
+			continue
+		if s1[1] == seen:
+			return None
+		shape = [h["n"][d] for d in reversed(range(h["effD"]))]   # k, j, i order for numpy
+		fields = {"rho": data[:h["ncells"]].reshape(shape)}
+		for d in range(h["effD"]):
+			fields["rhov%d" % d] = data[(1 + d)*h["ncells"]:(2 + d)*h["ncells"]].reshape(shape)
+		fields["rhoE"] = data[(1 + h["effD"])*h["ncells"]:].reshape(shape)
+		return h, {"published": s1[1], "iter": s1[2], "Tsim": s1[3], "dt": s1[4]}, fields
+	return None
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--name", default=None, help="segment name printed by the solver, e.g. /cdugks_1234")
+	parser.add_argument("--every", type=float, default=0.2, help="seconds between polls")
+	parser.add_argument("--plot", action="store_true", help="show the density as it evolves")
+	args = parser.parse_args()
+
+	path = segment_path(args.name)
+	with open(path, "rb") as f:
+		buf = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+	h = header(buf)
+	print("%s: pid %d, effD = %d, N = %s, published grid %s (stride %d)" % (path, h["pid"], h["effD"], h["N"], h["n"], h["stride"]))
+
+	if args.plot:
+		import matplotlib.pyplot as plt
+		plt.ion()
+		fig = plt.figure()
+
+	seen = 0
+	while True:
+		got = read(buf, seen)
+		if got is not None:
+			h, slot, fields = got
+			seen = slot["published"]
+			rho = fields["rho"]
+			print("iteration = %d, Tsim = %f, dt = %f, rho in [%f, %f], total energy = %e" % (slot["iter"], slot["Tsim"], slot["dt"], rho.min(), rho.max(), fields["rhoE"].sum()))
+			if args.plot:
+				fig.clf()
+				if h["effD"] == 1:
+					plt.plot(rho)
+				else:
+					plt.imshow(rho if h["effD"] == 2 else rho[rho.shape[0]//2], origin="lower")
+					plt.colorbar()
+				plt.title("rho, iteration %d, Tsim = %.4f" % (slot["iter"], slot["Tsim"]))
+				plt.pause(0.001)
+		elif header(buf)["done"]:
+			print("Run finished")
+			break
+		time.sleep(args.every)
+
+
+if __name__ == "__main__":
+	main()
@@ -4,6 +4,7 @@
 #include <math.h>
 
 #include "testProblem.hh"
+#include "InitialConditions.hh"
 
 
 void TestProblem(int* N, int* NV, int* Nc, int* Nv, int* BCs, double* Vmin, double* Vmax, int testProblem, double* R, double* K, double* Cv, double* gma, double* w , double* ur, double* Tr, double* Pr, int* effD){
@@ -70,26 +71,53 @@ void TestProblem(int* N, int* NV, int* Nc, int* Nv, int* BCs, double* Vmin, doub
 }
 
 
-void InitializeTestProblem(Cell* mesh, double* g, double* b, double* rho, double* rhov, double* rhoE, int testProblem, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD){
+void InitializeTestProblem(Cell* mesh, double* g, double* b, double* rho, double* rhov, double* rhoE, int testProblem, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, MomentBasis* M, int nthreads){
 
 
 
 	if (testProblem == 1){
-		SodShock(mesh, g, b, rho, rhov, rhoE, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
+		SodShock(mesh, rho, rhov, rhoE, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD);
 	}
 
 	else if (testProblem == 2){
-		KHI(mesh, g, b, rho, rhov, rhoE, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD); 
+		KHI(mesh, rho, rhov, rhoE, Co_X, Co_WX, Co_Y, Co_WY, Co_Z, Co_WZ, R, K, Cv, gma, w, ur, Tr, Pr, N, NV, effD); 
 
 	}
 
 	else if (testProblem == 3){
 		RTI(); //TODO: initialize
 	}
+
+	InitializeEquilibrium(g, b, rho, rhov, rhoE, Co_X, Co_Y, Co_Z, R, K, N, NV, effD, nthreads);
+
+	CheckInitialMoments(g, b, rho, rhov, rhoE, M, N, effD);
 }
 
+//Compare the discrete moments of the initial g/b against the W they were built from.
+//Large deviations mean the velocity grid does not resolve the initial Maxwellians.
+void CheckInitialMoments(double* g, double* b, double* rho, double* rhov, double* rhoE, MomentBasis* M, int* N, int effD){
+
+	int Nc = N[0]*N[1]*N[2];
+
+	double* Wg = new double[(1+effD)*Nc];
+	double* Wb = new double[Nc];
+	Moments(M, g, Nc, MOM_RHO, 1 + effD, Wg);
+	Moments(M, b, Nc, MOM_RHO, 1, Wb);
+
+	double erho = 0, erhov = 0, erhoE = 0;
+	for(int sidx = 0; sidx < Nc; sidx++){
+		erho = fmax(erho, fabs(Wg[MOM_RHO*Nc + sidx] - rho[sidx])/rho[sidx]);
+		for(int dim = 0; dim < effD; dim++){erhov = fmax(erhov, fabs(Wg[(MOM_XI + dim)*Nc + sidx] - rhov[effD*sidx + dim])/rho[sidx]);}
+		erhoE = fmax(erhoE, fabs(Wb[sidx] - rhoE[sidx])/rhoE[sidx]);
+	}
+	printf("Initial discrete moments: max rel. error rho = %e, rhov/rho = %e, rhoE = %e\n", erho, erhov, erhoE);
+
+	delete[] Wg;
+	delete[] Wb;
+}
 
-void SodShock(Cell* mesh, double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double rhoL, double rhoR, double PL, double PR){
+
+void SodShock(Cell* mesh, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double rhoL, double rhoR, double PL, double PR){
 	
 	int idx;
 	int Nx = N[0];
@@ -141,55 +169,7 @@ void SodShock(Cell* mesh, double* g, double* b, double* rho, double* rhov, doubl
 	}
 				
 
-	//Initialize g and b
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-
-				int sidx = i + Nx*j + Nx*Ny*k; //spatial index
-
-				double u = 0;
-				for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];}
-				u = sqrt(u);
-
-				double T = Temperature(rhoE[sidx]/rho[sidx], u);
-
-				//double rhotest = 0;
-				//double rhovxtest = 0;
-				//double rhoEtest = 0;
-
-				for(int vx = 0; vx < NV[0]; vx++){
-					for(int vy = 0; vy < NV[1]; vy++){
-						for(int vz = 0; vz < NV[2]; vz++){
-
-						
-						idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-
-
-						double c2 = 0;
-						double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
-
-						for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);} //TODO: Potential BUG, did not double check algebra.
-						g[idx] = geq(c2, rho[sidx], T);
-						b[idx] = g[idx]*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
-
-
-						//rhotest += g[idx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];//;
-						//rhovxtest += g[idx]*Co_X[vx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
-						//rhoEtest += b[idx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
-						//printf("Initial g[%d] = %f\n", idx, g[idx]);
-						//printf("Initial b[%d] = %f\n", idx, b[idx]);
-
-						}
-					}
-				}
-
-				//printf("Initialization W[%d] = {%f, %f, %f}\n", sidx, rhotest, rhovxtest, rhoEtest);
-			}
-
-		}
-
-	}
+	//g and b are built from W by InitializeEquilibrium
 
 
 
@@ -198,7 +178,7 @@ void SodShock(Cell* mesh, double* g, double* b, double* rho, double* rhov, doubl
 
 }
 
- void KHI(Cell* mesh, double* g, double* b, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double rhoT, double rhoB, double PT, double PB, double vrel, double amp){
+ void KHI(Cell* mesh, double* rho, double* rhov, double* rhoE, double* Co_X, double* Co_WX, double* Co_Y, double* Co_WY, double* Co_Z, double* Co_WZ, double R, double K, double Cv, double gma, double w, double ur, double Tr, double Pr, int* N, int* NV, int effD, double rhoT, double rhoB, double PT, double PB, double vrel, double amp){
 
 	int idx;
 	int Nx = N[0];
@@ -263,55 +243,7 @@ void SodShock(Cell* mesh, double* g, double* b, double* rho, double* rhov, doubl
 	}
 				
 
-	//Initialize g and b
-	for(int i = 0; i < N[0]; i++){
-		for(int j = 0; j < N[1]; j++){
-			for(int k = 0; k < N[2]; k++){
-
-				int sidx = i + Nx*j + Nx*Ny*k; //spatial index
-
-				double u = 0;
-				for(int dim = 0; dim < effD; dim++){u += rhov[effD*sidx + dim]/rho[sidx]*rhov[effD*sidx + dim]/rho[sidx];}
-				u = sqrt(u);
-
-				double T = Temperature(rhoE[sidx]/rho[sidx], u);
-
-				//double rhotest = 0;
-				//double rhovxtest = 0;
-				//double rhoEtest = 0;
-
-				for(int vx = 0; vx < NV[0]; vx++){
-					for(int vy = 0; vy < NV[1]; vy++){
-						for(int vz = 0; vz < NV[2]; vz++){
-
-						
-						idx = i + Nx*j + Nx*Ny*k + Nx*Ny*Nz*vx + Nx*Ny*Nz*NV[0]*vy + Nx*Ny*Nz*NV[0]*NV[1]*vz;
-
-
-						double c2 = 0;
-						double Xi[3] = {Co_X[vx], Co_Y[vy], Co_Z[vz]};
-
-						for(int dim = 0 ; dim < effD; dim++){ c2 += (Xi[dim]-rhov[effD*sidx + dim]/rho[sidx])*(Xi[dim]-rhov[effD*sidx + dim]/rho[sidx]);} //TODO: Potential BUG, did not double check algebra.
-						g[idx] = geq(c2, rho[sidx], T);
-						b[idx] = g[idx]*(Co_X[vx]*Co_X[vx] + Co_Y[vy]*Co_Y[vy] + Co_Z[vz]*Co_Z[vz] + (3-effD+K)*R*T)/2;
-
-
-						//rhotest += g[idx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];//;
-						//rhovxtest += g[idx]*Co_X[vx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
-						//rhoEtest += b[idx]*Co_WX[vx]*Co_WY[vy]*Co_WZ[vz];
-						//printf("Initial g[%d] = %f\n", idx, g[idx]);
-						//printf("Initial b[%d] = %f\n", idx, b[idx]);
-
-						}
-					}
-				}
-
-				//printf("Initialization W[%d] = {%f, %f, %f}\n", sidx, rhotest, rhovxtest, rhoEtest);
-			}
-
-		}
-
-	}
+	//g and b are built from W by InitializeEquilibrium
 
 
 
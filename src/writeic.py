@@ -0,0 +1,129 @@
+import argparse
+import numpy as np
+import struct
+
+# Writes initial condition files for the -f option of both versions, layout in ICFormat.hh.
+# Fields are indexed [k, j, i] (C order over z, y, x), so they flatten to sidx = i + N[0]*j + N[0]*N[1]*k.
+# Run as a script it writes the Sod shock tube of test problem 1: python3 writeic.py sod.ic
+# (--potential G adds the potential phi = -G*x, the same field as -a G but read from the file),
+# or with --problem khi / gresho the 32x32 shear layer and Gresho vortex the -x 1 splitting error is quoted for.
+
+IC_MAGIC = b'CDUGKSIC'
+IC_VERSION = 1
+IC_HEADER_BYTES = 512
+IC_W = 0
+IC_PHASE = 1
+
+
+def write_ic(path, effD, N, NV, BCs, Vmin, Vmax, R, K, w, ur, Tr, Pr, rho, rhov, rhoE, g = None, b = None, Tf = 0, dtdump = 0, phi = None):
+
+	# BCs: one per axis (low and high side the same) or six, low sides then high sides
+	if len(BCs) == 3:
+		BCs = list(BCs) + list(BCs)
+	Cv  = (3+K)*R/2
+	gma = (K+5)/(K+3)
+	kind = IC_W if g is None else IC_PHASE
+
+	header = struct.pack('<8s2i', IC_MAGIC, IC_VERSION, kind)
+	header += struct.pack('<13i', effD, *N, *NV, *BCs)
+	header += struct.pack('<i', 0) # Alignment of the doubles
+	header += struct.pack('<6d', *Vmin, *Vmax)
+	header += struct.pack('<8d', R, K, Cv, gma, w, ur, Tr, Pr)
+	header += struct.pack('<2d', Tf, dtdump)
+	header += struct.pack('<i', 0 if phi is None else 1)
+	header += b'\0'*(IC_HEADER_BYTES - len(header))
+
+	Nc = N[0]*N[1]*N[2]
+	V = np.zeros((Nc, 3))
+	V[:, :effD] = np.asarray(rhov, dtype = '<f8').reshape(Nc, -1)[:, :effD]
+
+	with open(path, 'wb') as f:
+		f.write(header)
+		f.write(np.asarray(rho, dtype = '<f8').reshape(Nc).tobytes())
+		f.write(V.astype('<f8').tobytes())
+		f.write(np.asarray(rhoE, dtype = '<f8').reshape(Nc).tobytes())
+		if kind == IC_PHASE:
+			# g[v, sidx] with v = vx + NV[0]*vy + NV[0]*NV[1]*vz
+			f.write(np.asarray(g, dtype = '<f8').reshape(-1).tobytes())
+			f.write(np.asarray(b, dtype = '<f8').reshape(-1).tobytes())
+		if phi is not None:
+			f.write(np.asarray(phi, dtype = '<f8').reshape(Nc).tobytes())
+
+
+def sod(path, potential = None):
+
+	# Sod shock tube, as test problem 1 of the C++ version
+	N = [256, 1, 1]
+	R = 0.5
+	K = 2.0
+	Cv = (3+K)*R/2
+	x = (np.arange(N[0]) + 0.5)/N[0]
+	rho = np.where(x <= 0.5, 1.0, 0.125)
+	P = np.where(x <= 0.5, 1.0, 0.1)
+	rhov = np.zeros(N[0])
+	rhoE = Cv*P/R
+	phi = None if potential is None else -potential*x
+
+	write_ic(path, 1, N, [256, 1, 1], [1, 0, 0], [-10, 0, 0], [10, 0, 0],
+	         R, K, 0.5, 1e-5, 1.0, 2/3., rho, rhov, rhoE, Tf = 0.15, dtdump = 0.15/200, phi = phi)
+
+
+def khi(path, n = 32):
+
+	# Periodic shear layer on an n x n grid, the 2D case the -x 1 splitting error is quoted for
+	R = 0.5
+	K = 2.0
+	Cv = (3+K)*R/2
+	x = (np.arange(n) + 0.5)/n
+	X, Y = np.meshgrid(x, x)
+	inner = np.abs(Y - 0.5) < 0.25
+	rho = np.where(inner, 2.0, 1.0)
+	P = np.ones_like(rho)
+	vx = np.where(inner, 0.5, -0.5)
+	vy = 0.05*np.sin(4*np.pi*X)
+	rhov = np.stack([rho*vx, rho*vy], -1)
+	rhoE = Cv*P/R + 0.5*rho*(vx**2 + vy**2)
+
+	write_ic(path, 2, [n, n, 1], [32, 32, 1], [0, 0, 0], [-8, -8, 0], [8, 8, 0],
+	         R, K, 0.5, 1e-4, 1.0, 0.5, rho, rhov, rhoE, Tf = 0.2, dtdump = 0.2)
+
+
+def gresho(path, n = 32):
+
+	# Gresho vortex on an n x n periodic grid: uniform density, a rotation whose speed peaks at 1 at r = 0.2
+	# and vanishes beyond r = 0.4, balanced by the pressure, with the background P0 = 5 (Mach 0.2 peak).
+	R = 0.5
+	K = 2.0
+	Cv = (3+K)*R/2
+	P0 = 5.0
+	x = (np.arange(n) + 0.5)/n
+	X, Y = np.meshgrid(x, x)
+	r = np.sqrt((X - 0.5)**2 + (Y - 0.5)**2)
+	uth = np.where(r < 0.2, 5*r, np.where(r < 0.4, 2 - 5*r, 0.0))
+	P = np.where(r < 0.2, P0 + 12.5*r**2,
+	    np.where(r < 0.4, P0 + 12.5*r**2 + 4 - 20*r + 4*np.log(np.maximum(r, 1e-30)/0.2), P0 - 2 + 4*np.log(2)))
+	th = np.arctan2(Y - 0.5, X - 0.5)
+	vx = -uth*np.sin(th)
+	vy = uth*np.cos(th)
+	rho = np.ones_like(r)
+	rhov = np.stack([vx, vy], -1)
+	rhoE = Cv*P/R + 0.5*(vx**2 + vy**2)
+
+	write_ic(path, 2, [n, n, 1], [32, 32, 1], [0, 0, 0], [-10, -10, 0], [10, 10, 0],
+	         R, K, 0.5, 1e-6, 1.0, 2/3., rho, rhov, rhoE, Tf = 0.2, dtdump = 0.2)
+
+
+if __name__ == '__main__':
+
+	parser = argparse.ArgumentParser()
+	parser.add_argument('path', nargs = '?', default = 'sod.ic')
+	parser.add_argument('--problem', choices = ['sod', 'khi', 'gresho'], default = 'sod')
+	parser.add_argument('--potential', type = float, default = None, metavar = 'G', help = 'sod only: gravitational potential -G*x')
+	args = parser.parse_args()
+
+	if args.problem == 'sod':
+		sod(args.path, args.potential)
+	elif args.problem == 'khi':
+		khi(args.path)
+	else:
+		gresho(args.path)